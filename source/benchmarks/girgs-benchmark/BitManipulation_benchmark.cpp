@@ -0,0 +1,82 @@
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <girgs/BitManipulation.h>
+
+
+namespace {
+
+const auto seed = 1337;
+
+template<unsigned int D>
+std::vector<std::array<std::uint32_t, D>> randomCoords(int n, unsigned int bits) {
+    auto gen = std::mt19937(seed);
+    auto dist = std::uniform_int_distribution<std::uint32_t>(0, (1u << bits) - 1);
+    auto coords = std::vector<std::array<std::uint32_t, D>>(n);
+    for (auto& point : coords)
+        for (auto& coord : point)
+            coord = dist(gen);
+    return coords;
+}
+
+} // namespace
+
+
+template<unsigned int D, typename Impl>
+static void BM_MortonDeposit(benchmark::State& state) {
+    const auto coords = randomCoords<D>(1 << 16, Impl::bitsPerCoord);
+    auto codes = std::vector<std::uint32_t>(coords.size());
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < coords.size(); ++i)
+            codes[i] = Impl::deposit(coords[i]);
+        benchmark::DoNotOptimize(codes.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetLabel(Impl::name());
+    state.SetItemsProcessed(state.iterations() * coords.size());
+}
+
+template<unsigned int D, typename Impl>
+static void BM_MortonExtract(benchmark::State& state) {
+    const auto coords = randomCoords<D>(1 << 16, Impl::bitsPerCoord);
+    auto codes = std::vector<std::uint32_t>(coords.size());
+    for (std::size_t i = 0; i < coords.size(); ++i)
+        codes[i] = Impl::deposit(coords[i]);
+    auto sum = std::array<std::uint32_t, D>();
+    for (auto _ : state) {
+        for (auto code : codes) {
+            const auto decoded = Impl::extract(code);
+            for (auto d = 0u; d < D; ++d)
+                sum[d] += decoded[d];
+        }
+        benchmark::DoNotOptimize(sum.data());
+    }
+    state.SetLabel(Impl::name());
+    state.SetItemsProcessed(state.iterations() * codes.size());
+}
+
+#define GIRGS_BENCHMARK_MORTON(D) \
+    BENCHMARK_TEMPLATE(BM_MortonDeposit, D, girgs::BitManipulation::Naive<D>); \
+    BENCHMARK_TEMPLATE(BM_MortonDeposit, D, girgs::BitManipulation::MagicBits<D>); \
+    BENCHMARK_TEMPLATE(BM_MortonExtract, D, girgs::BitManipulation::Naive<D>); \
+    BENCHMARK_TEMPLATE(BM_MortonExtract, D, girgs::BitManipulation::MagicBits<D>);
+
+GIRGS_BENCHMARK_MORTON(1)
+GIRGS_BENCHMARK_MORTON(2)
+GIRGS_BENCHMARK_MORTON(3)
+GIRGS_BENCHMARK_MORTON(4)
+
+#ifdef __BMI2__
+#define GIRGS_BENCHMARK_MORTON_BMI2(D) \
+    BENCHMARK_TEMPLATE(BM_MortonDeposit, D, girgs::BitManipulation::BMI2<D>); \
+    BENCHMARK_TEMPLATE(BM_MortonExtract, D, girgs::BitManipulation::BMI2<D>);
+
+GIRGS_BENCHMARK_MORTON_BMI2(1)
+GIRGS_BENCHMARK_MORTON_BMI2(2)
+GIRGS_BENCHMARK_MORTON_BMI2(3)
+GIRGS_BENCHMARK_MORTON_BMI2(4)
+#endif
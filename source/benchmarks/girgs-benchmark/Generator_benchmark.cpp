@@ -0,0 +1,106 @@
+#include <limits>
+
+#include <omp.h>
+
+#include <benchmark/benchmark.h>
+
+#include <girgs/Generator.h>
+
+
+namespace {
+
+const auto ple = -2.5;
+const auto avgDeg = 10.0;
+const auto weightSeed = 12;
+const auto positionSeed = 130;
+const auto samplingSeed = 1400;
+
+// memory of the graph stored in the generator divided by the number of nodes
+double bytesPerNode(const girgs::Generator& g) {
+    auto bytes = 0.0;
+    for (auto& node : g.graph())
+        bytes += sizeof(girgs::Node) + node.coord.capacity() * sizeof(double) + node.edges.capacity() * sizeof(girgs::Node*);
+    return bytes / g.graph().size();
+}
+
+// arguments {n, threads} with and without parallelism
+void nodesAndThreads(benchmark::internal::Benchmark* b) {
+    for (auto threads : {1, omp_get_num_procs()}) {
+        for (auto n = 1 << 14; n <= 1 << 20; n <<= 3)
+            b->Args({n, threads});
+        if (omp_get_num_procs() == 1)
+            break;
+    }
+}
+
+} // namespace
+
+
+static void BM_SetWeights(benchmark::State& state) {
+    const auto n = static_cast<int>(state.range(0));
+    omp_set_num_threads(static_cast<int>(state.range(1)));
+    for (auto _ : state) {
+        girgs::Generator g;
+        g.setWeights(n, ple, weightSeed);
+        benchmark::DoNotOptimize(g.graph().data());
+        state.counters["bytes/node"] = bytesPerNode(g);
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_SetWeights)->Apply(nodesAndThreads)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+
+static void BM_SetPositions(benchmark::State& state) {
+    const auto n = static_cast<int>(state.range(0));
+    const auto d = static_cast<int>(state.range(1));
+    for (auto _ : state) {
+        girgs::Generator g;
+        g.setPositions(n, d, positionSeed);
+        benchmark::DoNotOptimize(g.graph().data());
+        state.counters["bytes/node"] = bytesPerNode(g);
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_SetPositions)->Ranges({{1 << 14, 1 << 20}, {1, 4}})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+
+static void BM_ScaleWeights(benchmark::State& state) {
+    const auto n = static_cast<int>(state.range(0));
+    const auto alpha = state.range(1) ? 1.5 : std::numeric_limits<double>::infinity();
+    girgs::Generator g;
+    g.setWeights(n, ple, weightSeed);
+    const auto weights = g.weights();
+    for (auto _ : state) {
+        state.PauseTiming();
+        g.setWeights(weights);
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(g.scaleWeights(avgDeg, 2, alpha));
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_ScaleWeights)->Ranges({{1 << 14, 1 << 20}, {0, 1}})->Unit(benchmark::kMillisecond);
+
+
+template<unsigned int D, bool Threshold>
+static void BM_Generate(benchmark::State& state) {
+    const auto n = static_cast<int>(state.range(0));
+    const auto alpha = Threshold ? std::numeric_limits<double>::infinity() : 1.5;
+    omp_set_num_threads(static_cast<int>(state.range(1)));
+
+    girgs::Generator g;
+    g.setWeights(n, ple, weightSeed);
+    g.setPositions(n, D, positionSeed);
+    g.scaleWeights(avgDeg, D, alpha);
+
+    auto edges = 0.0;
+    for (auto _ : state) {
+        g.generate(alpha, samplingSeed);
+        edges += g.edges();
+    }
+    state.counters["edges/s"] = benchmark::Counter(edges, benchmark::Counter::kIsRate);
+    state.counters["bytes/node"] = bytesPerNode(g);
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK_TEMPLATE(BM_Generate, 1, false)->Apply(nodesAndThreads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Generate, 2, false)->Apply(nodesAndThreads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Generate, 2, true )->Apply(nodesAndThreads)->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,165 @@
+#include <array>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <omp.h>
+
+#include <benchmark/benchmark.h>
+
+#include <girgs/Generator.h>
+#include <girgs/SpatialTree.h>
+#include <girgs/SpatialTreeCoordinateHelper.h>
+#include <girgs/WeightLayer.h>
+
+
+namespace {
+
+const auto ple = -2.5;
+const auto avgDeg = 10.0;
+const auto seed = 1337;
+
+template<unsigned int D>
+std::vector<std::array<double, D>> randomPoints(std::size_t n) {
+    auto gen = std::mt19937(seed);
+    auto dist = std::uniform_real_distribution<>();
+    auto points = std::vector<std::array<double, D>>(n);
+    for (auto& point : points)
+        for (auto& coord : point)
+            coord = dist(gen);
+    return points;
+}
+
+// a graph with scaled weights and positions but without edges
+std::vector<girgs::Node> prepareGraph(girgs::NodeIndex n, unsigned int d, double alpha) {
+    girgs::Generator g;
+    g.setWeights(n, ple, seed);
+    g.setPositions(n, d, seed + 1);
+    g.scaleWeights(avgDeg, d, alpha);
+    auto graph = std::vector<girgs::Node>(n);
+    const auto weights = g.weights();
+    const auto positions = g.positions();
+    for (girgs::NodeIndex i = 0; i < n; ++i) {
+        graph[i].weight = weights[i];
+        graph[i].coord = positions[i];
+        graph[i].index = i;
+    }
+    return graph;
+}
+
+// arguments {n, threads} with and without parallelism
+void nodesAndThreads(benchmark::internal::Benchmark* b) {
+    for (auto threads : {1, omp_get_num_procs()}) {
+        for (auto n = 1 << 14; n <= 1 << 20; n <<= 3)
+            b->Args({n, threads});
+        if (omp_get_num_procs() == 1)
+            break;
+    }
+}
+
+} // namespace
+
+
+template<unsigned int D>
+static void BM_CellForPoint(benchmark::State& state) {
+    const auto level = static_cast<unsigned int>(state.range(0));
+    const auto helper = girgs::SpatialTreeCoordinateHelper<D>(level + 1);
+    const auto points = randomPoints<D>(1 << 16);
+    for (auto _ : state)
+        for (auto& point : points)
+            benchmark::DoNotOptimize(helper.cellForPoint(point, level));
+    state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK_TEMPLATE(BM_CellForPoint, 1)->Arg(16);
+BENCHMARK_TEMPLATE(BM_CellForPoint, 2)->Arg(8);
+BENCHMARK_TEMPLATE(BM_CellForPoint, 3)->Arg(5);
+
+
+template<unsigned int D>
+static void BM_CellPairPrimitives(benchmark::State& state) {
+    using Helper = girgs::SpatialTreeCoordinateHelper<D>;
+    const auto level = static_cast<unsigned int>(state.range(0));
+    const auto helper = Helper(level + 1);
+    auto gen = std::mt19937(seed);
+    auto cell = std::uniform_int_distribution<girgs::CellIndex>(Helper::firstCellOfLevel(level), Helper::firstCellOfLevel(level + 1) - 1);
+    auto pairs = std::vector<std::pair<girgs::CellIndex, girgs::CellIndex>>(1 << 16);
+    for (auto& pair : pairs)
+        pair = {cell(gen), cell(gen)};
+
+    for (auto _ : state) {
+        for (auto& pair : pairs) {
+            benchmark::DoNotOptimize(helper.touching(pair.first, pair.second, level));
+            benchmark::DoNotOptimize(helper.dist(pair.first, pair.second, level));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * pairs.size());
+}
+BENCHMARK_TEMPLATE(BM_CellPairPrimitives, 1)->Arg(16);
+BENCHMARK_TEMPLATE(BM_CellPairPrimitives, 2)->Arg(8);
+BENCHMARK_TEMPLATE(BM_CellPairPrimitives, 3)->Arg(5);
+
+
+template<unsigned int D>
+static void BM_WeightLayer(benchmark::State& state) {
+    const auto n = static_cast<girgs::NodeIndex>(state.range(0));
+    const auto level = static_cast<unsigned int>(state.range(1));
+    const auto helper = girgs::SpatialTreeCoordinateHelper<D>(level + 1);
+    const auto graph = prepareGraph(n, D, std::numeric_limits<double>::infinity());
+    auto nodes = std::vector<girgs::NodeIndex>(n);
+    std::iota(nodes.begin(), nodes.end(), girgs::NodeIndex(0));
+
+    for (auto _ : state) {
+        auto layer = girgs::WeightLayer<D>(0, level, helper, nodes, graph);
+        benchmark::DoNotOptimize(layer.indices().data());
+        auto bytes = layer.positions().capacity() * sizeof(std::array<double, D>)
+            + layer.weights().capacity() * sizeof(double)
+            + layer.indices().capacity() * sizeof(girgs::NodeIndex)
+            + (girgs::SpatialTreeCoordinateHelper<D>::numCellsInLevel(level) + 1) * sizeof(girgs::NodeIndex); // prefix sums
+        state.counters["bytes/node"] = static_cast<double>(bytes) / n;
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK_TEMPLATE(BM_WeightLayer, 1)->Args({1 << 20, 18})->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_WeightLayer, 2)->Args({1 << 20, 9})->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_WeightLayer, 3)->Args({1 << 20, 6})->Unit(benchmark::kMillisecond);
+
+
+template<unsigned int D, bool Threshold>
+static void BM_GenerateEdges(benchmark::State& state) {
+    const auto n = static_cast<girgs::NodeIndex>(state.range(0));
+    const auto threads = static_cast<int>(state.range(1));
+    const auto alpha = Threshold ? std::numeric_limits<double>::infinity() : 1.5;
+    omp_set_num_threads(threads);
+
+    auto graph = prepareGraph(n, D, alpha);
+
+    // count edges per thread, padded to avoid false sharing
+    auto counts = std::vector<long long>(8 * threads);
+    auto countEdge = [&counts](girgs::NodeIndex, girgs::NodeIndex, int tid) { ++counts[8 * tid]; };
+
+    // generateEdges builds the weight layers itself, the statistics separate that from the sampling
+    auto tree = girgs::SpatialTree<D, Threshold>();
+    auto stats = girgs::GenerationStats();
+    tree.setStatistics(&stats);
+    auto buildSeconds = 0.0;
+    auto samplingSeconds = 0.0;
+    for (auto _ : state) {
+        tree.generateEdges(graph, alpha, seed, countEdge);
+        buildSeconds += stats.buildSeconds;
+        samplingSeconds += stats.sequentialSeconds + stats.parallelSeconds;
+    }
+    auto edges = 0.0;
+    for (auto count : counts)
+        edges += count;
+    state.counters["edges/s"] = edges / samplingSeconds;
+    state.counters["build ms"] = 1000.0 * buildSeconds / state.iterations();
+    state.SetItemsProcessed(state.iterations() * n); // end-to-end including the build
+}
+BENCHMARK_TEMPLATE(BM_GenerateEdges, 1, false)->Apply(nodesAndThreads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_GenerateEdges, 1, true )->Apply(nodesAndThreads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_GenerateEdges, 2, false)->Apply(nodesAndThreads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_GenerateEdges, 2, true )->Apply(nodesAndThreads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_GenerateEdges, 3, false)->Apply(nodesAndThreads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_GenerateEdges, 4, false)->Apply(nodesAndThreads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_GenerateEdges, 5, false)->Apply(nodesAndThreads)->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,100 @@
+#include <vector>
+
+#include <omp.h>
+
+#include <benchmark/benchmark.h>
+
+#include <hypergirgs/Hyperbolic.h>
+#include <hypergirgs/HyperbolicTree.h>
+
+
+namespace {
+
+const auto alpha = 0.75; // ple = 2*alpha+1
+const auto avgDeg = 10;
+const auto radiiSeed = 12;
+const auto angleSeed = 130;
+const auto edgesSeed = 1400;
+
+// arguments {n, threads} with and without parallelism
+void nodesAndThreads(benchmark::internal::Benchmark* b) {
+    for (auto threads : {1, omp_get_num_procs()}) {
+        for (auto n = 1 << 14; n <= 1 << 20; n <<= 3)
+            b->Args({n, threads});
+        if (omp_get_num_procs() == 1)
+            break;
+    }
+}
+
+} // namespace
+
+
+static void BM_SampleRadii(benchmark::State& state) {
+    const auto n = static_cast<hypergirgs::NodeIndex>(state.range(0));
+    const auto R = hypergirgs::calculateRadius(n, alpha, 0, avgDeg);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(hypergirgs::sampleRadii(n, alpha, R, radiiSeed).data());
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_SampleRadii)->Range(1 << 14, 1 << 20)->Unit(benchmark::kMillisecond);
+
+
+static void BM_SampleAngles(benchmark::State& state) {
+    const auto n = static_cast<hypergirgs::NodeIndex>(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(hypergirgs::sampleAngles(n, angleSeed).data());
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_SampleAngles)->Range(1 << 14, 1 << 20)->Unit(benchmark::kMillisecond);
+
+
+template<bool Threshold>
+static void BM_HyperbolicTreeConstruction(benchmark::State& state) {
+    const auto n = static_cast<hypergirgs::NodeIndex>(state.range(0));
+    const auto T = Threshold ? 0.0 : 0.5;
+    omp_set_num_threads(static_cast<int>(state.range(1)));
+
+    const auto R = hypergirgs::calculateRadius(n, alpha, T, avgDeg);
+    auto radii = hypergirgs::sampleRadii(n, alpha, R, radiiSeed);
+    auto angles = hypergirgs::sampleAngles(n, angleSeed);
+    auto ignoreEdge = [](hypergirgs::NodeIndex, hypergirgs::NodeIndex, int) {};
+
+    for (auto _ : state) {
+        auto tree = hypergirgs::makeHyperbolicTree(radii, angles, T, R, ignoreEdge);
+        benchmark::DoNotOptimize(&tree);
+    }
+    // radius layers store one Point per node
+    state.counters["bytes/node"] = sizeof(hypergirgs::Point);
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK_TEMPLATE(BM_HyperbolicTreeConstruction, true )->Apply(nodesAndThreads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_HyperbolicTreeConstruction, false)->Apply(nodesAndThreads)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+
+template<bool Threshold>
+static void BM_HyperbolicTreeGenerate(benchmark::State& state) {
+    const auto n = static_cast<hypergirgs::NodeIndex>(state.range(0));
+    const auto threads = static_cast<int>(state.range(1));
+    const auto T = Threshold ? 0.0 : 0.5;
+    omp_set_num_threads(threads);
+
+    const auto R = hypergirgs::calculateRadius(n, alpha, T, avgDeg);
+    auto radii = hypergirgs::sampleRadii(n, alpha, R, radiiSeed);
+    auto angles = hypergirgs::sampleAngles(n, angleSeed);
+
+    // count edges per thread, padded to avoid false sharing
+    auto counts = std::vector<long long>(8 * threads);
+    auto countEdge = [&counts](hypergirgs::NodeIndex, hypergirgs::NodeIndex, int tid) { ++counts[8 * tid]; };
+    auto tree = hypergirgs::makeHyperbolicTree(radii, angles, T, R, countEdge);
+
+    for (auto _ : state)
+        tree.generate(edgesSeed);
+
+    auto edges = 0.0;
+    for (auto count : counts)
+        edges += count;
+    state.counters["edges/s"] = benchmark::Counter(edges, benchmark::Counter::kIsRate);
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK_TEMPLATE(BM_HyperbolicTreeGenerate, true )->Apply(nodesAndThreads)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_HyperbolicTreeGenerate, false)->Apply(nodesAndThreads)->UseRealTime()->Unit(benchmark::kMillisecond);
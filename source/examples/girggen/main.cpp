@@ -9,6 +9,7 @@
 
 #include <girgs/girgs-version.h>
 #include <girgs/Generator.h>
+#include <girgs/Tracer.h>
 
 
 using namespace std;
@@ -47,6 +48,15 @@ void rangeCheck(T value, T min, T max, string name, bool lex = false, bool hex =
 
 
 
+void writeTrace(const string& file) {
+    cout << "writing trace (.json) ...\t" << flush;
+    auto t1 = high_resolution_clock::now();
+    girgs::Tracer::global().write(file);
+    auto t2 = high_resolution_clock::now();
+    cout << "done in " << duration_cast<milliseconds>(t2 - t1).count() << "ms" << endl;
+}
+
+
 int main(int argc, char* argv[]) {
 
     // write help
@@ -61,9 +71,16 @@ int main(int argc, char* argv[]) {
             << "\t\t[-pseed anInt]      // position seed                            default 130\n"
             << "\t\t[-sseed anInt]      // sampling seed                            default 1400\n"
             << "\t\t[-threads anInt]    // number of threads to use                 default 1\n"
+            << "\t\t[-det 0|1]          // same graph for any number of threads     default 0\n"
             << "\t\t[-file aString]     // file name for output graph               default \"graph\"\n"
             << "\t\t[-dot 0|1]          // write result as dot (.dot)               default 0\n"
-            << "\t\t[-edge 0|1]         // write result as edgelist (.txt)          default 1\n";
+            << "\t\t[-edge 0|1]         // write result as edgelist (.txt)          default 1\n"
+            << "\t\t[-bin 0|1]          // write result as binary edgelist (.bin)   default 0\n"
+            << "\t\t[-shard anInt/anInt]// only sample shard i of k (implies -det 1) default 0/1\n"
+            << "\t\t[-stats 0|1]        // print statistics of the edge sampling    default 0\n"
+            << "\t\t[-trace 0|1]        // write chrome trace of sampling (.json)   default 0\n"
+            << "\t\t[-tracelevel anInt] // also trace cell pairs up to this level   default -1\n"
+            << "\t\t                    // (tracing needs a build with OPTION_TRACING)\n";
         return 0;
     }
 
@@ -79,7 +96,7 @@ int main(int argc, char* argv[]) {
 
     // read params
     auto params = parseArgs(argc, argv);
-    auto n      = !params["n"    ].empty()  ? stoi(params["n"    ]) : 10000;
+    auto n      = static_cast<girgs::NodeIndex>(!params["n"].empty() ? stoll(params["n"]) : 10000);
     auto d      = !params["d"    ].empty()  ? stoi(params["d"    ]) : 1;
     auto ple    = !params["ple"  ].empty()  ? stod(params["ple"  ]) : -2.5;
     auto alpha  = !params["alpha"].empty()  ? stod(params["alpha"]) : std::numeric_limits<double>::infinity();
@@ -88,9 +105,18 @@ int main(int argc, char* argv[]) {
     auto pseed  = !params["pseed"].empty()  ? stoi(params["pseed"]) : 130;
     auto sseed  = !params["sseed"].empty()  ? stoi(params["sseed"]) : 1400;
     auto threads= !params["threads"].empty()? stoi(params["threads"]) : 1;
+    auto det    = params["det" ] == "1";
     auto file   = !params["file" ].empty()  ? params["file"] : "graph";
     auto dot    = params["dot" ] == "1";
     auto edge   = params["edge"] != "0";
+    auto bin    = params["bin" ] == "1";
+    auto stats  = params["stats"] == "1";
+    auto trace  = params["trace"] == "1";
+    auto tracelevel = !params["tracelevel"].empty() ? stoi(params["tracelevel"]) : -1;
+    auto shard  = params["shard"];
+    auto slash  = shard.find('/');
+    auto shardIndex = slash != string::npos ? stoi(shard.substr(0, slash)) : 0;
+    auto numShards  = slash != string::npos ? stoi(shard.substr(slash + 1)) : 1;
 
     // log params and range checks
     cout << "using:\n";
@@ -104,9 +130,18 @@ int main(int argc, char* argv[]) {
     logParam(sseed, "sseed");
     rangeCheck(threads, 1, omp_get_max_threads(), "threads");
     omp_set_num_threads(threads);
+    logParam(det, "det");
     logParam(file, "file");
     logParam(dot, "dot");
     logParam(edge, "edge");
+    logParam(bin, "bin");
+    logParam(stats, "stats");
+    logParam(trace, "trace");
+    rangeCheck(tracelevel, -1, std::numeric_limits<int>::max(), "tracelevel");
+    if (trace && !girgs::Tracer::enabled())
+        cerr << "WARNING: girgs is built without OPTION_TRACING, the trace will be empty\n";
+    rangeCheck(numShards, 1, std::numeric_limits<int>::max(), "shards");
+    rangeCheck(shardIndex, 0, numShards, "shard", false, true);
     cout << "\n";
 
     auto t1 = high_resolution_clock::now();
@@ -114,6 +149,12 @@ int main(int argc, char* argv[]) {
 
     cout << "generating weights ...\t\t" << flush;
     girgs::Generator generator;
+    generator.setDeterministic(det);
+    generator.setShard(shardIndex, numShards);
+    girgs::GenerationStats statistics;
+    if (stats)
+        generator.setStatistics(&statistics);
+    girgs::Tracer::global().setMaxLevel(tracelevel);
     generator.setWeights(n, ple, wseed);
     auto t2 = high_resolution_clock::now();
     cout << "done in " << duration_cast<milliseconds>(t2 - t1).count() << "ms" << endl;
@@ -134,6 +175,10 @@ int main(int argc, char* argv[]) {
     generator.generate(alpha, sseed);
     auto t5 = high_resolution_clock::now();
     cout << "done in " << duration_cast<milliseconds>(t5 - t4).count() << "ms\tavg deg = " << generator.avg_degree() << endl;
+    if (stats)
+        statistics.print(cout);
+    if (trace)
+        writeTrace(file + ".json");
 
     if (dot) {
         cout << "writing .dot file ...\t\t" << flush;
@@ -151,5 +196,13 @@ int main(int argc, char* argv[]) {
         cout << "done in " << duration_cast<milliseconds>(t7 - t6).count() << "ms" << endl;
     }
 
+    if (bin) {
+        cout << "writing binary edge list (.bin) ...\t" << flush;
+        auto t6 = high_resolution_clock::now();
+        generator.saveBinaryEdgeList(file + ".bin");
+        auto t7 = high_resolution_clock::now();
+        cout << "done in " << duration_cast<milliseconds>(t7 - t6).count() << "ms" << endl;
+    }
+
     return 0;
 }
@@ -0,0 +1,130 @@
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include <omp.h>
+
+#include <girgs/BinaryEdgeList.h>
+
+
+using namespace std;
+using namespace chrono;
+
+
+// quotes an argument for the shell
+string quote(const string& arg) {
+    auto result = string("'");
+    for (auto c : arg) {
+        if (c == '\'')
+            result += "'\\''";
+        else
+            result += c;
+    }
+    return result + "'";
+}
+
+
+// girggen is expected next to this executable
+string girggenPath(const string& self) {
+    auto slash = self.find_last_of("/\\");
+    return (slash == string::npos ? string("./") : self.substr(0, slash + 1)) + "girggen";
+}
+
+
+// copies the pairs of all shard files into one binary edge list and returns the number of edges
+template<typename IndexType>
+uint64_t mergeShards(const vector<string>& shardFiles, const string& file) {
+    auto numNodes = uint64_t(0);
+    auto numEdges = uint64_t(0);
+    for (auto& shardFile : shardFiles) {
+        girgs::BinaryEdgeList shard(shardFile);
+        if (numNodes != 0 && numNodes != shard.numNodes())
+            throw runtime_error(shardFile + " belongs to a different graph");
+        numNodes = shard.numNodes();
+        numEdges += shard.numEdges();
+    }
+
+    girgs::BinaryEdgeListWriter writer(file, numNodes, numEdges, sizeof(IndexType));
+    auto out = writer.edges<IndexType>();
+    for (auto& shardFile : shardFiles) {
+        girgs::BinaryEdgeList shard(shardFile);
+        auto pairs = shard.edges<IndexType>();
+        out = copy(pairs, pairs + 2 * shard.numEdges(), out);
+    }
+    return numEdges;
+}
+
+
+int main(int argc, char* argv[]) {
+
+    // write help
+    if (argc < 3 || 0 == strcmp(argv[1], "--help") || 0 == strcmp(argv[1], "-help")) {
+        clog << "usage: ./girgshards k file [girggen parameters]\n"
+            << "\truns k girggen processes in parallel, each with -shard i/k, and merges their\n"
+            << "\tbinary edge lists into file.bin. All other parameters are passed to girggen,\n"
+            << "\tuse -threads to set the threads of each process. Seeds must not be negative.\n";
+        return 0;
+    }
+
+    const auto k = stoi(argv[1]);
+    const auto file = string(argv[2]);
+    if (k < 1) {
+        cerr << "ERROR: number of shards k = " << k << " must be positive\n";
+        return 1;
+    }
+
+    auto command = quote(girggenPath(argv[0]));
+    for (int i = 3; i < argc; ++i)
+        command += ' ' + quote(argv[i]);
+
+    auto shardFiles = vector<string>(k);
+    for (int i = 0; i < k; ++i)
+        shardFiles[i] = file + ".shard" + to_string(i);
+
+    // later parameters override earlier ones in girggen
+    auto t1 = high_resolution_clock::now();
+    cout << "running " << k << " shards ...\t" << flush;
+    auto failed = 0;
+    #pragma omp parallel for schedule(static, 1) num_threads(k) reduction(+:failed)
+    for (int i = 0; i < k; ++i) {
+        auto shardCommand = command + " -shard " + to_string(i) + '/' + to_string(k)
+            + " -file " + quote(shardFiles[i]) + " -edge 0 -dot 0 -bin 1 > " + quote(shardFiles[i] + ".log");
+        if (system(shardCommand.c_str()) != 0)
+            ++failed;
+    }
+    auto t2 = high_resolution_clock::now();
+    cout << "done in " << duration_cast<milliseconds>(t2 - t1).count() << "ms" << endl;
+    if (failed) {
+        cerr << "ERROR: " << failed << " shards failed, see " << file << ".shard*.log\n";
+        return 1;
+    }
+
+    cout << "merging edge lists (.bin) ...\t" << flush;
+    for (auto& shardFile : shardFiles)
+        shardFile += ".bin";
+    try {
+        auto indexBytes = girgs::BinaryEdgeList(shardFiles.front()).indexBytes();
+        auto edges = indexBytes == 4
+            ? mergeShards<uint32_t>(shardFiles, file + ".bin")
+            : mergeShards<uint64_t>(shardFiles, file + ".bin");
+        auto t3 = high_resolution_clock::now();
+        cout << "done in " << duration_cast<milliseconds>(t3 - t2).count() << "ms\tedges = " << edges << endl;
+    } catch (const runtime_error& error) {
+        cerr << "ERROR: " << error.what() << '\n';
+        return 1;
+    }
+
+    for (auto& shardFile : shardFiles) {
+        remove(shardFile.c_str());
+        remove((shardFile.substr(0, shardFile.size() - 4) + ".log").c_str());
+    }
+
+    return 0;
+}
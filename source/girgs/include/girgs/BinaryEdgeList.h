@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cassert>
+
+#include <girgs/girgs_api.h>
+
+
+namespace girgs {
+
+
+/**
+ * @brief
+ *  Header of the binary edge list format.
+ *  The header is followed by numEdges pairs of node indices. Each index is an unsigned integer of indexBytes (4 or 8) bytes.
+ *  All numbers are stored in the byte order of the machine that wrote the file (little endian on all common platforms).
+ */
+struct BinaryEdgeListHeader {
+    char          magic[8];   ///< always "GIRGEDGE" (not null terminated)
+    std::uint64_t numNodes;   ///< number of nodes, all indices are smaller
+    std::uint64_t numEdges;   ///< number of index pairs after the header
+    std::uint32_t indexBytes; ///< size of one index in bytes, either 4 or 8
+    std::uint32_t version;    ///< version of the format, currently 1
+};
+static_assert(sizeof(BinaryEdgeListHeader) == 32, "the header must not contain padding");
+
+
+/**
+ * @brief
+ *  Creates a binary edge list of known size and maps it into memory.
+ *  The index pairs can then be written concurrently, e.g. each thread fills its pre-counted slice.
+ *  The file is complete after the writer is destroyed.
+ *
+ *  On Windows the pairs are buffered in memory and written at destruction.
+ */
+class GIRGS_API BinaryEdgeListWriter
+{
+public:
+    /**
+     * @brief
+     *  Creates the file and writes the header.
+     *
+     * @param file
+     *  The name of the output file. An existing file is overwritten.
+     * @param numNodes
+     *  The number of nodes.
+     * @param numEdges
+     *  The exact number of pairs that will be written.
+     * @param indexBytes
+     *  The size of one index, either 4 or 8. Use indexBytesFor(std::uint64_t) to get the smallest fitting one.
+     *
+     * @throws std::runtime_error if the file cannot be created or mapped.
+     */
+    BinaryEdgeListWriter(const std::string& file, std::uint64_t numNodes, std::uint64_t numEdges, unsigned int indexBytes);
+    ~BinaryEdgeListWriter();
+
+    BinaryEdgeListWriter(const BinaryEdgeListWriter&) = delete;
+    BinaryEdgeListWriter& operator=(const BinaryEdgeListWriter&) = delete;
+
+    /**
+     * @return
+     *  Pointer to the first index of 2*numEdges indices. Pair k is stored at positions 2k and 2k+1.
+     *  IndexType must be an unsigned integer of indexBytes bytes.
+     */
+    template<typename IndexType>
+    IndexType* edges() {
+        assert(sizeof(IndexType) == m_indexBytes);
+        return reinterpret_cast<IndexType*>(m_data + sizeof(BinaryEdgeListHeader));
+    }
+
+    /// @return the smallest supported index size that can represent all indices of a graph with numNodes nodes
+    static unsigned int indexBytesFor(std::uint64_t numNodes) {
+        return numNodes <= (std::uint64_t(1) << 32) ? 4 : 8;
+    }
+
+protected:
+    std::string   m_file;       ///< name of the output file
+    unsigned int  m_indexBytes; ///< size of one index in bytes
+    std::size_t   m_size;       ///< size of the file in bytes
+    char*         m_data;       ///< start of the mapped (or buffered) file
+    int           m_fd;         ///< file descriptor of the mapped file
+    std::vector<char> m_buffer; ///< buffered file content if memory mapping is not available
+};
+
+
+/**
+ * @brief
+ *  Read only view of a binary edge list (see BinaryEdgeListHeader).
+ *  The file is mapped into memory, so the pairs are accessed without copying or parsing them.
+ *
+ *  On Windows the file is read into a buffer instead.
+ */
+class GIRGS_API BinaryEdgeList
+{
+public:
+    /**
+     * @brief
+     *  Opens and maps the file.
+     *
+     * @throws std::runtime_error if the file cannot be opened or is not a valid binary edge list.
+     */
+    explicit BinaryEdgeList(const std::string& file);
+    ~BinaryEdgeList();
+
+    BinaryEdgeList(const BinaryEdgeList&) = delete;
+    BinaryEdgeList& operator=(const BinaryEdgeList&) = delete;
+
+    /// @return the header of the file
+    const BinaryEdgeListHeader& header() const { return *reinterpret_cast<const BinaryEdgeListHeader*>(m_data); }
+
+    std::uint64_t numNodes() const { return header().numNodes; }
+    std::uint64_t numEdges() const { return header().numEdges; }
+    unsigned int indexBytes() const { return header().indexBytes; }
+
+    /**
+     * @return
+     *  Pointer to the first index of 2*numEdges() indices. Pair k is stored at positions 2k and 2k+1.
+     *  IndexType must be an unsigned integer of indexBytes() bytes.
+     */
+    template<typename IndexType>
+    const IndexType* edges() const {
+        assert(sizeof(IndexType) == indexBytes());
+        return reinterpret_cast<const IndexType*>(m_data + sizeof(BinaryEdgeListHeader));
+    }
+
+    /// @return the k-th pair independent of the index size
+    std::pair<std::uint64_t, std::uint64_t> edge(std::uint64_t k) const {
+        assert(k < numEdges());
+        if (indexBytes() == 4)
+            return {edges<std::uint32_t>()[2*k], edges<std::uint32_t>()[2*k+1]};
+        return {edges<std::uint64_t>()[2*k], edges<std::uint64_t>()[2*k+1]};
+    }
+
+protected:
+    std::size_t       m_size;   ///< size of the file in bytes
+    const char*       m_data;   ///< start of the mapped (or buffered) file
+    std::vector<char> m_buffer; ///< file content if memory mapping is not available
+};
+
+
+} // namespace girgs
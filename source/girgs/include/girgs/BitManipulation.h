@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+
+namespace girgs {
+
+/**
+ * @brief
+ *  Morton codes (bit interleaving) of D dimensional integer coordinates with 32 or 64 bit results.
+ *
+ *  Bit l of coordinate d is stored in bit l*D+d of the code. The code and the coordinates have the unsigned
+ *  type Code (std::uint32_t or std::uint64_t) and each coordinate may use bits(Code)/D bits.
+ *  All implementations expose the same static interface:
+ *   - deposit(coords) returns the Morton code of the coordinates,
+ *   - extract(code) returns the coordinates of a Morton code,
+ *   - name() returns a human readable name (used in tests and benchmarks).
+ *
+ *  BitManipulation::Default<D> is selected at compile time and uses the BMI2 instructions pdep / pext if the
+ *  target supports them (e.g. with -mbmi2 or -march=native) and the shift and mask implementation otherwise.
+ */
+namespace BitManipulation {
+
+/**
+ * @brief
+ *  Moves bit by bit. This is the reference implementation.
+ */
+template<unsigned int D, typename Code = std::uint32_t>
+struct Naive {
+    using code_type = Code;
+    static constexpr unsigned int bitsPerCoord = 8 * sizeof(Code) / D;
+
+    static std::string name() { return "Naive"; }
+
+    static Code deposit(const std::array<Code, D>& coords) noexcept;
+    static std::array<Code, D> extract(Code code) noexcept;
+};
+
+/**
+ * @brief
+ *  Uses word parallelism: in each of log2(32/D) rounds the bits are spread (or compacted) in groups
+ *  of equal size with one shift and one mask that are known at compile time.
+ */
+template<unsigned int D, typename Code = std::uint32_t>
+struct MagicBits {
+    using code_type = Code;
+    static constexpr unsigned int bitsPerCoord = 8 * sizeof(Code) / D;
+
+    static std::string name() { return "MagicBits"; }
+
+    static Code deposit(const std::array<Code, D>& coords) noexcept;
+    static std::array<Code, D> extract(Code code) noexcept;
+
+    /**
+     * @brief
+     *  Bit mask of the positions of the bits of one coordinate after they are spread in groups of size group.
+     *  Bit i of the coordinate is at position (i/group)*group*D + i%group.
+     *  With group=1 this gives the positions in the final Morton code.
+     */
+    static constexpr std::uint64_t mask(unsigned int group, unsigned int i = 0) {
+        return i == bitsPerCoord ? 0
+            : (std::uint64_t(1) << ((i / group) * group * D + i % group)) | mask(group, i + 1);
+    }
+
+protected:
+    static Code spread(Code x) noexcept;
+    static Code compact(Code x) noexcept;
+
+    // moves from groups of size 2*Group to groups of size Group and back
+    template<unsigned int Group> static std::uint64_t spreadStep(std::uint64_t x) noexcept;
+    template<unsigned int Group> static std::uint64_t compactStep(std::uint64_t x) noexcept;
+};
+
+#ifdef __BMI2__
+/**
+ * @brief
+ *  Uses one pdep (deposit) or pext (extract) instruction per coordinate.
+ */
+template<unsigned int D, typename Code = std::uint32_t>
+struct BMI2 {
+    using code_type = Code;
+    static constexpr unsigned int bitsPerCoord = 8 * sizeof(Code) / D;
+
+    static std::string name() { return "BMI2"; }
+
+    static Code deposit(const std::array<Code, D>& coords) noexcept;
+    static std::array<Code, D> extract(Code code) noexcept;
+};
+
+template<unsigned int D, typename Code = std::uint32_t>
+using Default = BMI2<D, Code>;
+#else
+template<unsigned int D, typename Code = std::uint32_t>
+using Default = MagicBits<D, Code>;
+#endif
+
+} // namespace BitManipulation
+
+} // namespace girgs
+
+#include <girgs/BitManipulation.inl>
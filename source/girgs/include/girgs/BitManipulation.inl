@@ -0,0 +1,127 @@
+
+namespace girgs {
+
+namespace BitManipulation {
+
+
+template<unsigned int D, typename Code>
+Code Naive<D, Code>::deposit(const std::array<Code, D>& coords) noexcept {
+    Code result = 0u;
+    unsigned int bit = 0;
+    for (auto l = 0u; l != bitsPerCoord; l++) {
+        for (auto d = 0u; d != D; d++) {
+            result |= ((coords[d] >> l) & 1u) << bit++;
+        }
+    }
+    return result;
+}
+
+template<unsigned int D, typename Code>
+std::array<Code, D> Naive<D, Code>::extract(Code code) noexcept {
+    std::array<Code, D> coords;
+    coords.fill(0);
+    unsigned int bit = 0;
+    for (auto l = 0u; l != bitsPerCoord; l++) {
+        for (auto d = 0u; d != D; d++) {
+            coords[d] |= ((code >> bit++) & 1u) << l;
+        }
+    }
+    return coords;
+}
+
+
+template<unsigned int D, typename Code>
+template<unsigned int Group>
+std::uint64_t MagicBits<D, Code>::spreadStep(std::uint64_t x) noexcept {
+    // nothing to do if all bits fit into one group
+    if (Group >= bitsPerCoord)
+        return x;
+
+    // the upper half of each group of size 2*Group moves up by Group*(D-1)
+    constexpr auto shift = Group < bitsPerCoord ? Group * (D - 1) : 0;
+    constexpr auto target = mask(Group);
+    return (x | (x << shift)) & target;
+}
+
+template<unsigned int D, typename Code>
+template<unsigned int Group>
+std::uint64_t MagicBits<D, Code>::compactStep(std::uint64_t x) noexcept {
+    if (Group >= bitsPerCoord)
+        return x;
+
+    constexpr auto shift = Group < bitsPerCoord ? Group * (D - 1) : 0;
+    constexpr auto target = mask(2 * Group);
+    return (x | (x >> shift)) & target;
+}
+
+template<unsigned int D, typename Code>
+Code MagicBits<D, Code>::spread(Code x) noexcept {
+    auto result = static_cast<std::uint64_t>(x) & mask(64);
+    result = spreadStep<32>(result);
+    result = spreadStep<16>(result);
+    result = spreadStep<8>(result);
+    result = spreadStep<4>(result);
+    result = spreadStep<2>(result);
+    result = spreadStep<1>(result);
+    return static_cast<Code>(result);
+}
+
+template<unsigned int D, typename Code>
+Code MagicBits<D, Code>::compact(Code x) noexcept {
+    auto result = static_cast<std::uint64_t>(x) & mask(1);
+    result = compactStep<1>(result);
+    result = compactStep<2>(result);
+    result = compactStep<4>(result);
+    result = compactStep<8>(result);
+    result = compactStep<16>(result);
+    result = compactStep<32>(result);
+    return static_cast<Code>(result);
+}
+
+template<unsigned int D, typename Code>
+Code MagicBits<D, Code>::deposit(const std::array<Code, D>& coords) noexcept {
+    Code result = 0u;
+    for (auto d = 0u; d != D; d++)
+        result |= spread(coords[d]) << d;
+    return result;
+}
+
+template<unsigned int D, typename Code>
+std::array<Code, D> MagicBits<D, Code>::extract(Code code) noexcept {
+    std::array<Code, D> coords;
+    for (auto d = 0u; d != D; d++)
+        coords[d] = compact(code >> d);
+    return coords;
+}
+
+
+#ifdef __BMI2__
+// overloads of the intrinsics for both code types
+inline std::uint32_t pdep(std::uint32_t x, std::uint32_t mask) noexcept { return _pdep_u32(x, mask); }
+inline std::uint64_t pdep(std::uint64_t x, std::uint64_t mask) noexcept { return _pdep_u64(x, mask); }
+inline std::uint32_t pext(std::uint32_t x, std::uint32_t mask) noexcept { return _pext_u32(x, mask); }
+inline std::uint64_t pext(std::uint64_t x, std::uint64_t mask) noexcept { return _pext_u64(x, mask); }
+
+template<unsigned int D, typename Code>
+Code BMI2<D, Code>::deposit(const std::array<Code, D>& coords) noexcept {
+    constexpr auto positions = static_cast<Code>(MagicBits<D, Code>::mask(1));
+    Code result = 0u;
+    for (auto d = 0u; d != D; d++)
+        result |= pdep(coords[d], static_cast<Code>(positions << d));
+    return result;
+}
+
+template<unsigned int D, typename Code>
+std::array<Code, D> BMI2<D, Code>::extract(Code code) noexcept {
+    constexpr auto positions = static_cast<Code>(MagicBits<D, Code>::mask(1));
+    std::array<Code, D> coords;
+    for (auto d = 0u; d != D; d++)
+        coords[d] = pext(code, static_cast<Code>(positions << d));
+    return coords;
+}
+#endif
+
+
+} // namespace BitManipulation
+
+} // namespace girgs
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace girgs {
+
+
+/**
+ * @brief
+ *  A graph in compressed sparse row format.
+ *  The neighbors of node u are stored in targets[offsets[u]] to targets[offsets[u+1]-1] in ascending order.
+ *
+ *  If the graph is not symmetric, each edge {u,v} is stored only once in the adjacency of the node that owned it during generation.
+ *  If the graph is symmetric, each edge is stored in both directions.
+ *
+ * @tparam IndexType
+ *  Unsigned integer type of the node indices (e.g. std::uint32_t or std::uint64_t). It must be able to hold n-1.
+ */
+template<typename IndexType>
+struct CompressedGraph {
+    using index_type = IndexType;
+
+    std::vector<std::uint64_t> offsets; ///< n+1 offsets into targets, offsets[n] equals the length of targets
+    std::vector<IndexType>     targets; ///< concatenated adjacency of all nodes
+    bool symmetric = false;             ///< whether each edge is stored in both directions
+
+    std::size_t numNodes() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    std::uint64_t numEdges() const { return symmetric ? targets.size() / 2 : targets.size(); }
+
+    std::uint64_t degree(IndexType u) const { return offsets[u+1] - offsets[u]; }
+    const IndexType* neighborsBegin(IndexType u) const { return targets.data() + offsets[u]; }
+    const IndexType* neighborsEnd(IndexType u) const { return targets.data() + offsets[u+1]; }
+};
+
+
+} // namespace girgs
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+
+namespace girgs {
+
+
+/**
+ * @brief
+ *  A counter based random engine that satisfies the UniformRandomBitGenerator concept.
+ *  The i-th output is a bijective mix of key + i*gamma (SplitMix64), so the engine has no state besides the
+ *  key and a counter. A fresh engine can be constructed for each unit of work by hashing its identification
+ *  (e.g. seed, cell pair, and layer pair) into the key. The random numbers of a unit then do not depend
+ *  on which thread processes it or in which order the units are processed.
+ */
+class CounterBasedEngine
+{
+public:
+    using result_type = std::uint64_t;
+
+    static constexpr result_type min() { return std::numeric_limits<result_type>::min(); }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    /**
+     * @brief
+     *  Creates an engine for the unit of work identified by the given values.
+     *
+     * @param seed
+     *  The user provided seed.
+     * @param a, b, c, d
+     *  Identification of the unit of work. Different tuples result in independent streams.
+     */
+    CounterBasedEngine(std::uint64_t seed, std::uint64_t a = 0, std::uint64_t b = 0, std::uint64_t c = 0, std::uint64_t d = 0)
+        : m_key(mix(mix(mix(mix(mix(seed) ^ a) ^ b) ^ c) ^ d))
+        , m_counter(0)
+    {}
+
+    result_type operator()() {
+        return mix(m_key + (++m_counter) * c_gamma);
+    }
+
+    /// skips the next z outputs
+    void discard(unsigned long long z) { m_counter += z; }
+
+    /// the SplitMix64 finalizer, a bijection on 64 bit integers with good avalanche properties
+    static std::uint64_t mix(std::uint64_t z) {
+        z += c_gamma;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+protected:
+    static constexpr std::uint64_t c_gamma = 0x9E3779B97F4A7C15ull; ///< golden ratio increment of SplitMix64
+
+    std::uint64_t m_key;     ///< hash of the unit of work
+    std::uint64_t m_counter; ///< number of outputs drawn so far
+};
+
+
+} // namespace girgs
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+
+namespace girgs {
+
+/**
+ * @brief
+ *  Approximations of log2 and exp2 with guaranteed error bounds.
+ *  They consist of bit manipulation, polynomials and one division only, so loops using them can be vectorized.
+ *  Callers use the error bounds to decide when the approximation is not precise enough and the exact
+ *  (but slow) std::pow has to be used.
+ */
+namespace FastMath {
+
+/// upper bound of the absolute error of log2
+constexpr double c_log2Error = 2e-9;
+
+/// upper bound of the relative error of exp2
+constexpr double c_exp2Error = 1e-9;
+
+/**
+ * @brief
+ *  Computes log2(x) with absolute error at most #c_log2Error.
+ *
+ * @param x
+ *  A positive normal double, i.e. x >= std::numeric_limits<double>::min(). The result is garbage otherwise.
+ */
+inline double log2(double x) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(x));
+
+    // x = 2^exponent * mantissa with mantissa in [1,2)
+    auto exponent = static_cast<double>(static_cast<int>((bits >> 52) & 0x7ff) - 1023);
+    bits = (bits & 0x000fffffffffffffull) | 0x3ff0000000000000ull;
+    double mantissa;
+    std::memcpy(&mantissa, &bits, sizeof(mantissa));
+
+    // move the mantissa to [sqrt(1/2), sqrt(2)]
+    const auto large = mantissa > 1.4142135623730951;
+    mantissa = large ? 0.5 * mantissa : mantissa;
+    exponent = large ? exponent + 1.0 : exponent;
+
+    // ln(m) = 2 atanh(s) = 2 (s + s^3/3 + s^5/5 + ...) with |s| = |(m-1)/(m+1)| <= 0.1716
+    // the terms from s^11 on sum up to less than 2 s^11/11 / (1-s^2) < 7.3e-10
+    const auto s = (mantissa - 1.0) / (mantissa + 1.0);
+    const auto s2 = s * s;
+    const auto ln = 2.0 * s * (1.0 + s2 * (1.0/3 + s2 * (1.0/5 + s2 * (1.0/7 + s2 * (1.0/9)))));
+    return exponent + ln * 1.4426950408889634; // 1/ln(2)
+}
+
+/**
+ * @brief
+ *  Computes 2^y with relative error at most #c_exp2Error.
+ *
+ * @param y
+ *  The exponent, must be in [-1000, 1000].
+ */
+inline double exp2(double y) {
+    // y = i + f with integer i and f in [-0.5, 0.5]
+    const auto i = static_cast<int>(y < 0.0 ? y - 0.5 : y + 0.5);
+    const auto g = (y - i) * 0.6931471805599453; // f*ln(2) in [-0.347, 0.347]
+
+    // e^g by its Taylor polynomial of degree 8, the remainder is at most |g|^9/9! e^|g| < 3e-10
+    const auto poly = 1.0 + g * (1.0 + g * (1.0/2 + g * (1.0/6 + g * (1.0/24 + g * (1.0/120
+                    + g * (1.0/720 + g * (1.0/5040 + g * (1.0/40320))))))));
+
+    // 2^i by setting the exponent bits
+    const auto scaleBits = static_cast<std::uint64_t>(i + 1023) << 52;
+    double scale;
+    std::memcpy(&scale, &scaleBits, sizeof(scale));
+    return poly * scale;
+}
+
+} // namespace FastMath
+
+} // namespace girgs
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+
+namespace girgs {
+
+
+/**
+ * @brief
+ *  Opt-in statistics of one edge generation that are also collected in release builds (see Generator::setStatistics).
+ *  Each thread counts into its own slot, so counting needs no synchronization.
+ */
+struct GenerationStats
+{
+    static constexpr unsigned int c_maxLevels = 64; ///< deeper levels are counted in the last entry
+    static constexpr std::size_t c_cacheLine = 64;  ///< assumed size of a cache line in bytes
+
+    /**
+     * @brief
+     *  The counters of one thread. std::allocator ignores alignas before C++17,
+     *  so a whole cache line of padding keeps the counters of different threads apart instead.
+     */
+    struct ThreadCounters {
+        std::uint64_t typeIPairs = 0;       ///< node pairs checked in touching cell pairs (each pair once)
+        std::uint64_t typeIICandidates = 0; ///< candidate pairs drawn in non touching cell pairs
+        std::uint64_t typeIIAccepted = 0;   ///< candidates that became edges
+        std::array<std::uint64_t, c_maxLevels> cellPairVisits; ///< visited cell pairs per level
+        char padding[c_cacheLine];
+
+        ThreadCounters() { cellPairVisits.fill(0); }
+    };
+
+    std::vector<ThreadCounters> threads; ///< one slot per thread
+    unsigned int levels = 0;             ///< number of levels of the spatial data structure
+
+    double buildSeconds = 0.0;       ///< building the layers and lookup tables
+    double sequentialSeconds = 0.0;  ///< sampling before the parallel phase (everything if sampled sequentially)
+    double parallelSeconds = 0.0;    ///< sampling the cell buckets of the parallel phase
+
+    /// clears all counters and times and prepares one slot per thread
+    void reset(int numThreads, unsigned int numLevels) {
+        threads.assign(numThreads, ThreadCounters());
+        levels = numLevels;
+        buildSeconds = sequentialSeconds = parallelSeconds = 0.0;
+    }
+
+    /// counts a visit of a cell pair in level by thread
+    void countVisit(int thread, unsigned int level) {
+        ++threads[thread].cellPairVisits[std::min(level, c_maxLevels - 1)];
+    }
+
+    /// @return the sum of a counter over all threads
+    template<typename Counter>
+    std::uint64_t total(Counter counter) const {
+        auto sum = std::uint64_t(0);
+        for (auto& each : threads)
+            sum += counter(each);
+        return sum;
+    }
+
+    std::uint64_t typeIPairs() const { return total([](const ThreadCounters& c) { return c.typeIPairs; }); }
+    std::uint64_t typeIICandidates() const { return total([](const ThreadCounters& c) { return c.typeIICandidates; }); }
+    std::uint64_t typeIIAccepted() const { return total([](const ThreadCounters& c) { return c.typeIIAccepted; }); }
+    std::uint64_t cellPairVisits(unsigned int level) const {
+        return total([level](const ThreadCounters& c) { return c.cellPairVisits[std::min(level, c_maxLevels - 1)]; });
+    }
+
+    /// writes a human readable report
+    void print(std::ostream& out) const {
+        out << "phases:\n"
+            << "\tbuild\t\t" << buildSeconds * 1000.0 << "ms\n"
+            << "\tsequential\t" << sequentialSeconds * 1000.0 << "ms\n"
+            << "\tparallel\t" << parallelSeconds * 1000.0 << "ms\n"
+            << "type I pairs\t\t" << typeIPairs() << '\n'
+            << "type II candidates\t" << typeIICandidates() << '\n'
+            << "type II accepted\t" << typeIIAccepted() << '\n'
+            << "cell pairs per level:\n";
+        for (auto level = 0u; level < levels && level < c_maxLevels; ++level)
+            out << '\t' << level << '\t' << cellPairVisits(level) << '\n';
+        out << "type I pairs + type II candidates per thread:\n";
+        for (std::size_t t = 0; t < threads.size(); ++t)
+            out << '\t' << t << '\t' << threads[t].typeIPairs + threads[t].typeIICandidates << '\n';
+    }
+};
+
+
+} // namespace girgs
@@ -4,9 +4,13 @@
 #include <vector>
 #include <string>
 #include <functional>
+#include <cstdint>
 
 #include <girgs/girgs_api.h>
+#include <girgs/IndexTypes.h>
 #include <girgs/Node.h>
+#include <girgs/CompressedGraph.h>
+#include <girgs/GenerationStats.h>
 
 
 namespace girgs {
@@ -37,6 +41,7 @@ public:
     /**
      * @brief
      *  Set new weights implicitly. The weights are sampled according to a power law distribution between [1, n)
+     *  The weights are sampled in parallel and do not depend on the number of threads.
      *
      * @param n
      *  The size of the graph. Should match with size of positions.
@@ -45,7 +50,7 @@ public:
      * @param weightSeed
      *  A seed for weight sampling. Should not be equal to the position seed.
      */
-    void setWeights(int n, double ple, int weightSeed);
+    void setWeights(NodeIndex n, double ple, int weightSeed);
 
     /**
      * @brief
@@ -59,6 +64,7 @@ public:
     /**
      * @brief
      *  Samples d dimensional coordinates for n points on a torus \f$[0,1)^d\f$.
+     *  The coordinates are sampled in parallel and do not depend on the number of threads.
      * @param n
      *  Size of the graph.
      * @param dimension
@@ -66,7 +72,7 @@ public:
      * @param positionSeed
      *  Seed to sample the positions.
      */
-    void setPositions(int n, int dimension, int positionSeed);
+    void setPositions(NodeIndex n, int dimension, int positionSeed);
 
     /**
      * @brief
@@ -92,6 +98,57 @@ public:
      */
     double scaleWeights(double desiredAvgDegree, int dimension, double alpha);
 
+    /**
+     * @brief
+     *  Enables or disables the deterministic sampling mode (disabled by default).
+     *  In deterministic mode the randomness for each unit of work is derived from a counter based generator
+     *  keyed by the sampling seed and the unit itself (see SpatialTree::SpatialTree(bool)).
+     *  The same seed then yields the same graph for any number of threads, including the order of Node::edges.
+     *  Note that the deterministic mode samples a different graph than the default mode for the same seed.
+     *
+     * @param deterministic
+     *  Whether subsequent calls of generate use the deterministic mode.
+     */
+    void setDeterministic(bool deterministic) { m_deterministic = deterministic; }
+
+    /**
+     * @return whether the deterministic sampling mode is enabled (see setDeterministic(bool))
+     */
+    bool deterministic() const { return m_deterministic; }
+
+    /**
+     * @brief
+     *  Restricts subsequent calls of generate to one shard of the graph (by default there is one shard).
+     *  Each shard samples exactly the edges whose source cell in the spatial data structure it owns
+     *  (see SpatialTree::ownsCell), so k processes with the same weights, positions, and seeds can sample
+     *  one graph together, e.g. on several hosts. The union of the edges of all k shards equals the graph sampled
+     *  by a single process in deterministic mode. With more than one shard, the deterministic mode is used regardless of
+     *  setDeterministic(bool).
+     *
+     * @param shard
+     *  Index of the shard to sample, in [0, numShards).
+     * @param numShards
+     *  Number of shards the graph is split into.
+     */
+    void setShard(int shard, int numShards);
+
+    /// @return the index of the shard that is sampled (see setShard(int, int))
+    int shard() const { return m_shard; }
+
+    /// @return the number of shards the graph is split into (see setShard(int, int))
+    int numShards() const { return m_numShards; }
+
+    /**
+     * @brief
+     *  Enables the collection of statistics in subsequent calls of generate, also in release builds.
+     *  The statistics are reset at the start of each generation and cost a few counter increments per cell pair
+     *  and per sampled cell block.
+     *
+     * @param stats
+     *  The statistics to fill, must outlive the generations. Nullptr (the default) disables the collection.
+     */
+    void setStatistics(GenerationStats* stats) { m_stats = stats; }
+
     /**
      * @brief
      *  Samples edges according to the current weights and positions.
@@ -107,6 +164,50 @@ public:
      */
     void generate(double alpha, int samplingSeed);
 
+    /**
+     * @brief
+     *  Samples edges according to the current weights and positions and passes them to a callback.
+     *  In contrast to generate(double, int) the edges are not stored, so the graph() accessors do not see them.
+     *  Edges stored by a previous call of generate(double, int) are removed from graph().
+     *  This reduces the memory of the generator to O(n), e.g. to pipe edges into own storage or onto disk.
+     *
+     * @pre Weights and positions must be set and have equal length.
+     *
+     * @param alpha
+     *  Same as in generate(double, int).
+     * @param samplingSeed
+     *  Same as in generate(double, int).
+     * @param edgeCallback
+     *  Is called as edgeCallback(u, v, threadId) exactly once for each edge {u,v} (see SpatialTree::generateEdges).
+     *  The node indices u and v are of type NodeIndex.
+     */
+    template<typename EdgeCallback>
+    void generate(double alpha, int samplingSeed, EdgeCallback& edgeCallback);
+
+    /**
+     * @brief
+     *  Samples edges according to the current weights and positions and returns them in compressed sparse row format.
+     *  The edges are collected in per thread buffers during generation and then merged into the result in parallel.
+     *  Like generate(double, int, EdgeCallback&), the graph() accessors do not see the edges.
+     *
+     * @pre Weights and positions must be set and have equal length.
+     *
+     * @tparam IndexType
+     *  Unsigned integer type for node indices in the result. Must be able to hold n-1.
+     * @param alpha
+     *  Same as in generate(double, int).
+     * @param samplingSeed
+     *  Same as in generate(double, int). The same seed yields the same graph as generate(double, int).
+     * @param symmetric
+     *  If true, each edge is stored in the adjacency of both endpoints, otherwise only in the adjacency of one of them.
+     * @return
+     *  The sampled graph with ascending sorted adjacencies.
+     *
+     * @throws std::overflow_error if n-1 does not fit into IndexType.
+     */
+    template<typename IndexType>
+    CompressedGraph<IndexType> generateCompressed(double alpha, int samplingSeed, bool symmetric = false);
+
     /**
      * @brief
      *  Convenience method that sets weights and positions, scales weights, and samples the edges.
@@ -125,21 +226,21 @@ public:
      * @param dimension
      *  Dimension of the geometry.
      * @param ple
-     *  The power law exponent to sample the weights. (see setWeights(int, double, int))
+     *  The power law exponent to sample the weights. (see setWeights(NodeIndex, double, int))
      * @param alpha
      *  Edge probability parameter.
      * @param desiredAvgDegree
      *  Desired average degree. (see scaleWeights(double, int, double))
      * @param weightSeed
-     *  Seed to sample the weights. Should not be equal to positionSeed. (see setWeights(int, double, int))
+     *  Seed to sample the weights. Should not be equal to positionSeed. (see setWeights(NodeIndex, double, int))
      * @param positionSeed
-     *  Seed to sample the positions. Should not be equal to weightSeed. (see setPositions(int, int, int))
+     *  Seed to sample the positions. Should not be equal to weightSeed. (see setPositions(NodeIndex, int, int))
      * @param samplingSeed
      *  Seed to sample the edges. (see generate(double, int))
      * @return
      *  A graph which is move constructed from the #m_graph member of the current Generator instance.
      */
-    std::vector<Node> generate(int n, int dimension, double ple, double alpha, double desiredAvgDegree, int weightSeed, int positionSeed, int samplingSeed);
+    std::vector<Node> generate(NodeIndex n, int dimension, double ple, double alpha, double desiredAvgDegree, int weightSeed, int positionSeed, int samplingSeed);
 
     /**
     *  @brief generates a threshold GIRG. (i.e. nodes u,v are connected if \f$ || x_u - x_v || < (w_u w_v / W)^{1/\alpha} \f$)
@@ -160,7 +261,7 @@ public:
     /**
      * @return the number of edges in the current graph
      */
-    unsigned int edges() const;
+    std::uint64_t edges() const;
 
     /**
      * @brief
@@ -178,12 +279,27 @@ public:
      *  The first line contains the number of nodes and the number of edges.
      *  Then for each edge there is a line with the indices (zero based) of the two endpoints.
      *  All numbers are separated by spaces.
+     *  The lines are formatted by all threads in parallel and written in large blocks.
      *
      * @param file
      *  The name of the output file.
      */
     void saveEdgeList(std::string file) const;
 
+    /**
+     * @brief
+     *  Saves the graph as a binary edge list (see BinaryEdgeListHeader) that can be read with BinaryEdgeList.
+     *  Indices use 4 bytes if possible and 8 bytes otherwise.
+     *  The edges appear in the same order as in saveEdgeList(std::string) const.
+     *  The file is memory mapped and all threads write the edges of their nodes concurrently.
+     *
+     * @param file
+     *  The name of the output file.
+     *
+     * @throws std::runtime_error if the file cannot be created.
+     */
+    void saveBinaryEdgeList(std::string file) const;
+
 
     /**
      * @brief
@@ -205,15 +321,25 @@ public:
 
 private:
     // helper
-    double estimateWeightScalingThreshold(const std::vector<double>& weights, double desiredAvgDegree, int dimension) const;
-    double estimateWeightScaling(const std::vector<double>& weights, double desiredAvgDegree, int dimension, double alpha) const;
+    double estimateWeightScalingThreshold(std::vector<double> weights, double desiredAvgDegree, int dimension) const;
+    double estimateWeightScaling(std::vector<double> weights, double desiredAvgDegree, int dimension, double alpha) const;
 
     double exponentialSearch(std::function<double(double)> f, double desiredValue, double accuracy = 0.02, double lower = 1.0, double upper = 2.0) const;
 
+    // samples the edges with a SpatialTree of dimension D, specialized for the threshold model if alpha is infinity
+    template<unsigned int D, typename EdgeCallback>
+    void generateInDimension(double alpha, int samplingSeed, EdgeCallback& edgeCallback);
+
 protected:
 
     std::vector<Node> m_graph;  ///< stores the current graph including weights and positions
+    bool m_deterministic = false; ///< sample edges independent of the number of threads (see setDeterministic(bool))
+    int m_shard = 0;              ///< index of the sampled shard (see setShard(int, int))
+    int m_numShards = 1;          ///< number of shards the graph is split into (see setShard(int, int))
+    GenerationStats* m_stats = nullptr; ///< statistics to fill or nullptr (see setStatistics(GenerationStats*))
 };
 
 
 } // namespace girgs
+
+#include <girgs/Generator.inl>
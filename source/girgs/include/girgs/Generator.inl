@@ -0,0 +1,118 @@
+#include <iostream>
+#include <utility>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <cassert>
+
+#include <omp.h>
+
+#include <girgs/SpatialTree.h>
+#include <girgs/PrefixSum.h>
+
+
+namespace girgs {
+
+
+template<typename EdgeCallback>
+void Generator::generate(double alpha, int samplingSeed, EdgeCallback& edgeCallback) {
+    assert(!m_graph.empty());
+    // the edges of a previous generation do not belong to the new graph
+    for(auto& each : m_graph) each.edges.clear();
+    auto dimension = m_graph.front().coord.size();
+    switch(dimension) {
+        case 1: generateInDimension<1>(alpha, samplingSeed, edgeCallback); break;
+        case 2: generateInDimension<2>(alpha, samplingSeed, edgeCallback); break;
+        case 3: generateInDimension<3>(alpha, samplingSeed, edgeCallback); break;
+        case 4: generateInDimension<4>(alpha, samplingSeed, edgeCallback); break;
+        case 5: generateInDimension<5>(alpha, samplingSeed, edgeCallback); break;
+        default:
+            std::cout << "Dimension " << dimension << " not supported." << std::endl;
+            std::cout << "No edges generated." << std::endl;
+            break;
+    }
+}
+
+
+template<unsigned int D, typename EdgeCallback>
+void Generator::generateInDimension(double alpha, int samplingSeed, EdgeCallback& edgeCallback) {
+    // the threshold model has its own specialization without any randomness
+    if (alpha == std::numeric_limits<double>::infinity()) {
+        SpatialTree<D, true> tree(m_deterministic, m_shard, m_numShards);
+        tree.setStatistics(m_stats);
+        tree.generateEdges(m_graph, alpha, samplingSeed, edgeCallback);
+    } else {
+        SpatialTree<D> tree(m_deterministic, m_shard, m_numShards);
+        tree.setStatistics(m_stats);
+        tree.generateEdges(m_graph, alpha, samplingSeed, edgeCallback);
+    }
+}
+
+
+template<typename IndexType>
+CompressedGraph<IndexType> Generator::generateCompressed(double alpha, int samplingSeed, bool symmetric) {
+    assert(!m_graph.empty());
+    // node indices are truncated in the buffers below, so this must also hold in release builds
+    if (m_graph.size() - 1 > static_cast<unsigned long long>(std::numeric_limits<IndexType>::max()))
+        throw std::overflow_error("generateCompressed: " + std::to_string(m_graph.size()) + " nodes do not fit into the index type");
+    const auto n = static_cast<long long>(m_graph.size());
+
+    // sample edges into one buffer per thread
+    auto buffers = std::vector<std::vector<std::pair<IndexType, IndexType>>>(omp_get_max_threads());
+    auto addEdge = [&buffers](NodeIndex u, NodeIndex v, int tid) {
+        buffers[tid].emplace_back(static_cast<IndexType>(u), static_cast<IndexType>(v));
+    };
+    generate(alpha, samplingSeed, addEdge);
+    const auto num_buffers = static_cast<int>(buffers.size());
+
+    auto result = CompressedGraph<IndexType>();
+    result.symmetric = symmetric;
+    result.offsets.assign(n+1, 0);
+
+    // count degrees
+    auto& degrees = result.offsets;
+    #pragma omp parallel for schedule(dynamic)
+    for(int t = 0; t < num_buffers; ++t) {
+        for(auto& edge : buffers[t]) {
+            #pragma omp atomic
+            ++degrees[edge.first];
+            if(symmetric) {
+                #pragma omp atomic
+                ++degrees[edge.second];
+            }
+        }
+    }
+
+    // degrees to offsets and allocate targets
+    result.targets.resize(exclusivePrefixSum(result.offsets));
+
+    // scatter edges, each node has a cursor that points to its next free slot
+    auto cursors = std::vector<std::uint64_t>(result.offsets.begin(), result.offsets.end() - 1);
+    #pragma omp parallel for schedule(dynamic)
+    for(int t = 0; t < num_buffers; ++t) {
+        for(auto& edge : buffers[t]) {
+            std::uint64_t pos;
+            #pragma omp atomic capture
+            pos = cursors[edge.first]++;
+            result.targets[pos] = edge.second;
+            if(symmetric) {
+                #pragma omp atomic capture
+                pos = cursors[edge.second]++;
+                result.targets[pos] = edge.first;
+            }
+        }
+        // release memory as soon as possible
+        std::vector<std::pair<IndexType, IndexType>>().swap(buffers[t]);
+    }
+
+    // the scatter order depends on thread timing, so sort adjacencies to get a deterministic result
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(long long u = 0; u < n; ++u)
+        std::sort(result.targets.begin() + result.offsets[u], result.targets.begin() + result.offsets[u+1]);
+
+    return result;
+}
+
+
+} // namespace girgs
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+
+namespace girgs {
+
+/**
+ * @brief
+ *  Integer types of node and cell indices.
+ *
+ *  By default both are 32 bit which keeps the spatial data structures compact. This limits graphs to
+ *  \f$2^{31}-1\f$ nodes and the spatial tree to 32 bits of Morton codes per level.
+ *  Configure with OPTION_64BIT_INDICES (which defines GIRGS_64BIT_INDICES for the library and all its users)
+ *  to use 64 bit indices for larger graphs.
+ */
+#ifdef GIRGS_64BIT_INDICES
+using NodeIndex = std::int64_t;  ///< index of a node in the graph, also used for counts of nodes
+using CellIndex = std::uint64_t; ///< index of a cell in the spatial tree (see SpatialTreeCoordinateHelper)
+#else
+using NodeIndex = int;           ///< index of a node in the graph, also used for counts of nodes
+using CellIndex = std::uint32_t; ///< index of a cell in the spatial tree (see SpatialTreeCoordinateHelper)
+#endif
+
+} // namespace girgs
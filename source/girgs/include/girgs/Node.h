@@ -4,6 +4,7 @@
 #include <vector>
 
 #include <girgs/girgs_api.h>
+#include <girgs/IndexTypes.h>
 
 
 namespace girgs {
@@ -15,7 +16,7 @@ namespace girgs {
 struct GIRGS_API Node {
     std::vector<double> coord;
     double              weight;
-    int                 index;
+    NodeIndex           index;
     std::vector<Node*>  edges;
 };
 
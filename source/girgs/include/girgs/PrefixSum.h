@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+#include <omp.h>
+
+
+namespace girgs {
+
+
+/**
+ * @brief
+ *  Replaces all values by their exclusive prefix sum, i.e. values[i] becomes the sum of all values[j] with j<i.
+ *  Large inputs are processed in parallel with one block per thread (sum of blocks, scan over block sums, local scans).
+ *
+ * @param values
+ *  The values to sum up.
+ * @return
+ *  The sum over all values.
+ */
+template<typename T>
+T exclusivePrefixSum(std::vector<T>& values) {
+    const auto n = static_cast<long long>(values.size());
+    const auto num_threads = n > 100000 ? omp_get_max_threads() : 1;
+    auto block_sums = std::vector<T>(num_threads + 1, T());
+    auto total = T();
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        const auto tid = omp_get_thread_num();
+        const auto blocks = omp_get_num_threads(); // may be less than requested
+        const auto begin = n * tid / blocks;
+        const auto end = n * (tid+1) / blocks;
+
+        auto sum = T();
+        for(auto i = begin; i < end; ++i)
+            sum += values[i];
+        block_sums[tid+1] = sum;
+
+        #pragma omp barrier
+        #pragma omp single
+        {
+            for(auto t = 1; t <= blocks; ++t)
+                block_sums[t] += block_sums[t-1];
+            total = block_sums[blocks];
+        } // implicit barrier
+
+        sum = block_sums[tid];
+        for(auto i = begin; i < end; ++i) {
+            const auto tmp = values[i];
+            values[i] = sum;
+            sum += tmp;
+        }
+    }
+
+    return total;
+}
+
+
+} // namespace girgs
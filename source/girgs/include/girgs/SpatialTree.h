@@ -3,14 +3,21 @@
 
 #include <vector>
 #include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <random>
 #include <limits>
 #include <numeric>
+#include <queue>
 #include <cassert>
 
 #include <omp.h>
 
+#include <girgs/CounterBasedEngine.h>
+#include <girgs/FastMath.h>
+#include <girgs/GenerationStats.h>
 #include <girgs/SpatialTreeCoordinateHelper.h>
+#include <girgs/Tracer.h>
 #include <girgs/WeightLayer.h>
 #include <girgs/Node.h>
 
@@ -25,14 +32,48 @@ namespace girgs {
  *
  * @tparam D
  *  Dimension of the underlying geometry.
+ * @tparam Threshold
+ *  If true, the tree only supports the threshold model (alpha = infinity).
+ *  It then skips all type 2 code and needs no random numbers. Instead of dist^D < w_u*w_v/W each pair is
+ *  checked as dist < r_u*r_v with precomputed radii \f$r_u = (w_u/\sqrt{W})^{1/D}\f$.
+ *  Otherwise, any alpha is supported (including infinity with runtime checks).
  */
-template<unsigned int D>
+template<unsigned int D, bool Threshold = false>
 class SpatialTree
 {
 public:
     static const auto dimension = D;
 
-    SpatialTree() = default;
+    /**
+     * @brief
+     *  Creates the method object.
+     *
+     * @param deterministic
+     *  If true, the randomness for each pair of cells and weight layers is derived from a CounterBasedEngine
+     *  keyed by the seed, the cells, and the layers. The sampled graph then is independent of the number of threads
+     *  and the whole recursion is split into tasks (see visitCell_tasks). Otherwise thread i uses a random generator
+     *  seeded with seed+i.
+     * @param shard
+     *  Index of the shard to sample, in [0, numShards).
+     * @param numShards
+     *  If greater than 1, only the edges whose source cell is owned by the given shard are sampled (see ownsCell).
+     *  The randomness then has to be derived from the cells, so sharding implies the deterministic mode.
+     *  The union of the edges of all shards is the graph sampled without sharding in deterministic mode.
+     */
+    explicit SpatialTree(bool deterministic = false, int shard = 0, int numShards = 1)
+        : m_deterministic(deterministic || numShards > 1), m_shard(shard), m_numShards(numShards)
+    {
+        assert(0 <= shard && shard < numShards);
+    }
+
+    /**
+     * @brief
+     *  Enables the collection of statistics during generateEdges.
+     *
+     * @param stats
+     *  Is reset and filled by each call of generateEdges. Nullptr (the default) disables the collection.
+     */
+    void setStatistics(GenerationStats* stats) { m_stats = stats; }
 
     /**
      * @brief
@@ -48,12 +89,40 @@ public:
      * @param seed
      *  The seed for the edge sampling.
      *  If OpenMP is given more than one thread, thread i uses seed+i.
-     *  This means that results are only reproducible for a combination of seed and thread number.
+     *  This means that results are only reproducible for a combination of seed and thread number,
+     *  unless the tree was created in deterministic mode.
      */
     void generateEdges(std::vector<Node>& graph, double alpha, int seed);
 
+    /**
+     * @brief
+     *  Same as generateEdges(std::vector<Node>&, double, int) but hands each sampled edge to a callback
+     *  instead of storing it in Node::edges. The graph is only used for its weights and positions.
+     *
+     * @param graph
+     *  Same as in generateEdges(std::vector<Node>&, double, int).
+     * @param alpha
+     *  Same as in generateEdges(std::vector<Node>&, double, int).
+     * @param seed
+     *  Same as in generateEdges(std::vector<Node>&, double, int).
+     * @param edgeCallback
+     *  Is called as edgeCallback(u, v, threadId) exactly once for each edge {u,v} where u and v are node indices.
+     *  Calls from different threads happen concurrently. However, all calls with the same u happen in the same thread
+     *  at any point in time, so data owned by u can be modified without synchronization.
+     */
+    template<typename EdgeCallback>
+    void generateEdges(std::vector<Node>& graph, double alpha, int seed, EdgeCallback& edgeCallback);
+
 protected:
 
+    /**
+     * @brief
+     *  Implements generateEdges(std::vector<Node>&, double, int, EdgeCallback&).
+     *  With GIRGS_TRACING that method wraps the callback to count the edges of each thread for the Tracer.
+     */
+    template<typename EdgeCallback>
+    void sampleEdges(std::vector<Node>& graph, double alpha, int seed, EdgeCallback& edgeCallback);
+
     /**
      * @brief
      *  A recursive function that samples all edges between points in cells A and B.
@@ -66,30 +135,126 @@ protected:
      *  The reverse edges sampled by this function are not stored.
      * @param level
      *  The level from which A and B are, meaning cellA and cellB must be in the same level.
+     * @param edgeCallback
+     *  Receives all edges sampled by this function.
      */
-    void visitCellPair(unsigned int cellA, unsigned int cellB, unsigned int level);
+    template<typename EdgeCallback>
+    void visitCellPair(CellIndex cellA, CellIndex cellB, unsigned int level, EdgeCallback& edgeCallback);
 
     /**
      * @brief
-     *  Same as visitCellPair(unsigned int, unsigned int, unsigned int) but stops recursion before first_parallel_level.
+     *  Same as visitCellPair(unsigned int, unsigned int, unsigned int, EdgeCallback&) but stops recursion before first_parallel_level.
      *  Instead, the calls that would be made in this level are saved in parallel_calls.
      *  The saved calls are grouped by their (level local) cellA parameter.
      *
      * @param cellA
-     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int).
+     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int, EdgeCallback&).
      * @param cellB
-     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int).
+     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int, EdgeCallback&).
      * @param level
-     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int).
+     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int, EdgeCallback&).
      * @param first_parallel_level
-     *  The level before which we "saw off" the recursion.
-     *  To get sufficient parallel cells (the outer size of parallel_calls) this should be computed as
-     *  \f$ 2^{dl} \geq kt \f$ solved for l (d dimension, l first_parallel_level, t threads, k tuning parameter).
-     *  We get \f$ l \geq \log_2(kt) / d \f$.
+     *  The level before which we "saw off" the recursion (see chooseFirstParallelLevel).
      * @param parallel_calls
+     * @param edgeCallback
+     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int, EdgeCallback&).
+     */
+    template<typename EdgeCallback>
+    void visitCellPair_sequentialStart(CellIndex cellA, CellIndex cellB, unsigned int level,
+            unsigned int first_parallel_level, std::vector<std::vector<CellIndex>>& parallel_calls,
+            EdgeCallback& edgeCallback);
+
+    /**
+     * @brief
+     *  Samples all edges of the cell pairs with cellA as source in level, then continues with the children of cellA.
+     *  Children with at least #c_taskMinPoints points become OpenMP tasks, the others are visited by the current task.
+     *  Each task is the only one that samples edges with source in its cell and it spawns its children only after its
+     *  own pairs are done, so the edges of each node are produced in the same order for any number of threads.
+     *  Only used if the randomness does not depend on the thread, i.e. in deterministic mode or in the threshold model.
+     *
+     * @param cellA
+     *  The source cell for edges, same as in visitCellPair(unsigned int, unsigned int, unsigned int, EdgeCallback&).
+     * @param cellsB
+     *  All target cells of cellA in level, i.e. the children of touching cells of the parent of cellA.
+     * @param level
+     *  The level of cellA and cellsB.
+     * @param first_parallel_level
+     *  The level in which the cells are dealt to the shards (see ownsCell), unused without sharding.
+     * @param edgeCallback
+     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int, EdgeCallback&).
+     */
+    template<typename EdgeCallback>
+    void visitCell_tasks(CellIndex cellA, const std::vector<CellIndex>& cellsB, unsigned int level,
+            unsigned int first_parallel_level, EdgeCallback& edgeCallback);
+
+    /**
+     * @brief
+     *  Whether the cell pairs with cellA as source are sampled by this shard.
+     *  The cells of each level down to the first parallel level are dealt round robin to the shards by their
+     *  level local index, such that the heavy cells of the upper levels and the cells of the first parallel level
+     *  are spread over all shards. Deeper cells belong to the shard of their ancestor in the first parallel level.
+     *  Sharding implies the deterministic mode, so only visitCell_tasks checks the ownership.
+     *
+     * @param cellA
+     *  The source cell of a visited cell pair.
+     * @param level
+     *  The level of cellA, at most the first parallel level.
+     */
+    bool ownsCell(CellIndex cellA, unsigned int level) const;
+
+    /// number of points in cell of all weight layers that are compared in level or deeper
+    NodeIndex pointsInCell(CellIndex cell, unsigned int level) const;
+
+    /**
+     * @brief
+     *  Estimates the work of the bucket of the parallel phase rooted in cell.
+     *  A layer pair \f$(i,j)\f$ compares \f$|V_i^A| \cdot |V_j^A|\f$ node pairs in touching cells of its level.
+     *  Each deeper level shrinks the touching fraction by \f$2^{-d}\f$. The points of the cell are added for the
+     *  work that does not depend on the pairs, e.g. the type 2 samples.
+     *  Only relative costs of cells in the same level are meaningful.
+     *
+     * @param cell
+     *  A cell of level.
+     * @param level
+     *  A candidate for the first parallel level.
+     */
+    double estimateBucketCost(CellIndex cell, unsigned int level) const;
+
+    /**
+     * @brief
+     *  Chooses the level in which the recursion is split into buckets for the parallel phase.
+     *  Starting with the first level that has a bucket for each task, the level is deepened while the
+     *  costliest bucket exceeds the work per task divided by #c_bucketBalance, but at most until there are
+     *  #c_maxBucketsPerTask buckets per task.
+     *  The choice only depends on the points and numTasks, so all shards agree on it.
+     *
+     * @param numTasks
+     *  The number of threads, or a constant that does not depend on them in deterministic mode.
+     * @param costs
+     *  Is filled with the estimated costs of all buckets in the chosen level (see estimateBucketCost).
+     * @return
+     *  The first parallel level.
+     */
+    unsigned int chooseFirstParallelLevel(int numTasks, std::vector<double>& costs) const;
+
+    /**
+     * @brief
+     *  Deterministic longest processing time first partition of the buckets to threads:
+     *  the costliest remaining bucket goes to the thread with the least load, ties are broken by index.
+     *  So the assignment only depends on the costs and the number of threads, which keeps the random
+     *  generators of the threads reproducible.
+     *
+     * @param costs
+     *  The estimated cost of each bucket.
+     * @param numThreads
+     *  The number of threads.
+     * @return
+     *  The indices of the buckets of each thread in descending cost.
      */
-    void visitCellPair_sequentialStart(unsigned int cellA, unsigned int cellB, unsigned int level,
-            unsigned int first_parallel_level, std::vector<std::vector<unsigned int>>& parallel_calls);
+    static std::vector<std::vector<int>> assignBuckets(const std::vector<double>& costs, int numThreads);
+
+    /// @return the indices of the buckets in descending cost, ties in ascending index
+    static std::vector<int> bucketsByCost(const std::vector<double>& costs);
 
     /**
      * @brief
@@ -97,17 +262,67 @@ protected:
      *  Type 1 means the cells A and B must touch or be identical.
      *
      * @param cellA
-     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int).
+     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int, EdgeCallback&).
      * @param cellB
-     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int).
+     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int, EdgeCallback&).
      * @param level
-     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int).
+     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int, EdgeCallback&).
      * @param i
      *  The weight layer for all considered nodes in cellA.
      * @param j
      *  The weight layer for all considered nodes in cellB.
+     * @param edgeCallback
+     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int, EdgeCallback&).
+     *
+     *  The random numbers are drawn from the generator of the current thread or,
+     *  in deterministic mode, from a CounterBasedEngine keyed by seed, cells, and layers.
+     */
+    template<typename EdgeCallback>
+    void sampleTypeI(CellIndex cellA, CellIndex cellB, unsigned int level, unsigned int i, unsigned int j, EdgeCallback& edgeCallback);
+
+    /**
+     * @brief
+     *  Same as sampleTypeI(unsigned int, unsigned int, unsigned int, unsigned int, unsigned int, EdgeCallback&)
+     *  but draws all random numbers from gen.
      */
-    void sampleTypeI(unsigned int cellA, unsigned int cellB, unsigned int level, unsigned int i, unsigned int j);
+    template<typename EdgeCallback, typename Engine>
+    void sampleTypeI(CellIndex cellA, CellIndex cellB, unsigned int level, unsigned int i, unsigned int j, Engine& gen, EdgeCallback& edgeCallback);
+
+    /**
+     * @brief
+     *  Same as sampleTypeI(unsigned int, unsigned int, unsigned int, unsigned int, unsigned int, EdgeCallback&)
+     *  for the threshold model. Compares the distance of each pair against the product of their radii (see #m_radii).
+     */
+    template<typename EdgeCallback>
+    void sampleTypeIThreshold(CellIndex cellA, CellIndex cellB, unsigned int level, unsigned int i, unsigned int j, EdgeCallback& edgeCallback);
+
+    /**
+     * @brief
+     *  Whether the node pairs of a type 1 comparison are split into blocks of rows that are sampled as tasks.
+     *  Only in a parallel region and if the randomness does not depend on the thread (see visitCell_tasks).
+     *
+     * @param pairs
+     *  The number of node pairs of the comparison.
+     */
+    bool splitsTypeI(std::uint64_t pairs) const;
+
+    /**
+     * @brief
+     *  Calls sampleRows(beginA, endA, skippedPairs) for blocks of about #c_typeISplitPairs node pairs as tasks
+     *  and waits for them. The rows of a block are the nodes [beginA, endA) of cell A, so the blocks produce edges
+     *  of disjoint source nodes. skippedPairs is the number of pairs in the rows before the block.
+     *
+     * @param sizeA
+     *  The number of rows.
+     * @param sizeB
+     *  The number of pairs in each row if not sameSet.
+     * @param sameSet
+     *  Whether the pairs are the unordered pairs of a single set, i.e. row k has sizeA-1-k pairs.
+     * @param sampleRows
+     *  Samples the pairs of a block of rows.
+     */
+    template<typename SampleRows>
+    void sampleTypeIRowBlocks(NodeIndex sizeA, NodeIndex sizeB, bool sameSet, SampleRows& sampleRows) const;
 
     /**
      * @brief
@@ -115,17 +330,32 @@ protected:
      *  Type 2 means the cells A and B must not touch.
      *
      * @param cellA
-     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int).
+     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int, EdgeCallback&).
      * @param cellB
-     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int).
+     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int, EdgeCallback&).
      * @param level
-     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int).
+     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int, EdgeCallback&).
+     * @param cellDistance
+     *  The distance of cellA and cellB in units of cells (see SpatialTreeCoordinateHelper::cellDistance).
      * @param i
      *  The weight layer for all considered nodes in cellA.
      * @param j
      *  The weight layer for all considered nodes in cellB.
+     * @param edgeCallback
+     *  Same as in visitCellPair(unsigned int, unsigned int, unsigned int, EdgeCallback&).
+     *
+     *  The random numbers are drawn like in sampleTypeI(unsigned int, unsigned int, unsigned int, unsigned int, unsigned int, EdgeCallback&).
+     */
+    template<typename EdgeCallback>
+    void sampleTypeII(CellIndex cellA, CellIndex cellB, unsigned int level, int cellDistance, unsigned int i, unsigned int j, EdgeCallback& edgeCallback);
+
+    /**
+     * @brief
+     *  Same as sampleTypeII(unsigned int, unsigned int, unsigned int, int, unsigned int, unsigned int, EdgeCallback&)
+     *  but draws all random numbers from gen.
      */
-    void sampleTypeII(unsigned int cellA, unsigned int cellB, unsigned int level, unsigned int i, unsigned int j);
+    template<typename EdgeCallback, typename Engine>
+    void sampleTypeII(CellIndex cellA, CellIndex cellB, unsigned int level, int cellDistance, unsigned int i, unsigned int j, Engine& gen, EdgeCallback& edgeCallback);
 
     /**
      * @brief
@@ -178,7 +408,85 @@ protected:
      */
     unsigned int partitioningBaseLevel(int layer1, int layer2) const;
 
-    bool checkEdgeExplicit(double dist, double w1, double w2);
+    /**
+     * @brief
+     *  Samples the edges between one point of cell A and a block of at most c_typeIBlockSize consecutive points of cell B.
+     *  Distances, weight terms and probabilities of the whole block are computed in vectorizable loops first.
+     *  For finite alpha they are then compared against a batch of uniforms that are drawn in pair order,
+     *  such that the result equals checking the pairs one by one.
+     *
+     * @param posA, weightA, powerA, indexA
+     *  The point of cell A, powerA is its entry in #m_weight_powers.
+     * @param posB, weightB, powerB, indexB
+     *  Pointers to the first point of the block in the point arrays of cell B and in #m_weight_powers.
+     * @param size
+     *  Number of points in the block.
+     */
+    template<typename EdgeCallback, typename Engine>
+    void sampleTypeIBlock(
+            const std::array<double, D>& posA, double weightA, double powerA, NodeIndex indexA,
+            const std::array<double, D>* posB, const double* weightB, const double* powerB, const NodeIndex* indexB, int size,
+            Engine& gen, EdgeCallback& edgeCallback, int threadId);
+
+    /**
+     * @brief
+     *  Approximates the connection probability \f$(w_u w_v/W)^\alpha / dist^{\alpha D}\f$ (not capped at 1)
+     *  without std::pow. The result is within a factor of 1 +- #m_approximationError of the exact value or NaN
+     *  if the distance is too small for the approximation.
+     *
+     * @param dist
+     *  The distance of the two points.
+     * @param weightPowerA, weightPowerB
+     *  The entries of both points in #m_weight_powers.
+     */
+    double approximateProbability(double dist, double weightPowerA, double weightPowerB) const;
+
+    /**
+     * @brief
+     *  Decides whether uniform is below the exact probability, which is only computed if the approximation
+     *  does not suffice. The result thus is the same as comparing against the exact probability.
+     *
+     * @param uniform
+     *  A random number in [0,1).
+     * @param approximation
+     *  Approximation of the probability with relative error at most #m_approximationError or NaN.
+     * @param exactProbability
+     *  Callable without arguments that returns the exact probability.
+     */
+    template<typename ExactProbability>
+    bool acceptEdge(double uniform, double approximation, ExactProbability exactProbability) const;
+
+    /// for each weight layer (w/sqrt(W))^exponent for all of its points in the same order as their weights
+    std::vector<std::vector<double>> scaledWeightPowers(double exponent) const;
+
+    /**
+     * @brief
+     *  Upper bound of the connection probability of all type 2 pairs of two weight layers in two cells
+     *  and what is needed to skip over the pairs that are not considered.
+     */
+    struct TypeIIBound {
+        double probability;     ///< upper bound of the connection probability, capped at 1
+        double invLog1mp;       ///< \f$1/\log(1-p)\f$, the number of skipped pairs is \f$\lfloor\log(1-u)/\log(1-p)\rfloor\f$ for uniform u
+    };
+
+    /**
+     * @brief
+     *  Fills #m_typeII_bounds. The bound only depends on the levels, the weight layers, and the distance of the cells.
+     *  The latter is at least 2 for cells that do not touch and at most #c_maxTypeIICellDistance
+     *  since type 2 pairs are children of touching cells.
+     */
+    void initTypeIIBounds();
+
+    /// looks up the entry of #m_typeII_bounds for cells in level with given distance and the weight layers i and j
+    const TypeIIBound& typeIIBound(int cellDistance, unsigned int level, unsigned int i, unsigned int j) const;
+
+    static constexpr int c_typeIBlockSize = 64; ///< number of pairs processed together in sampleTypeIBlock
+    static constexpr int c_maxTypeIICellDistance = 3; ///< the largest distance of two cells that are compared type 2
+    static constexpr int c_bucketBalance = 4; ///< the costliest bucket should take at most this fraction of the work per task
+    static constexpr int c_maxBucketsPerTask = 64; ///< limits the depth of the first parallel level
+    static constexpr int c_deterministicTasks = 64; ///< tasks assumed for the first parallel level if it must not depend on the threads
+    static constexpr NodeIndex c_taskMinPoints = 1024; ///< cells with less points are visited by the task of their parent (see visitCell_tasks)
+    static constexpr std::uint64_t c_typeISplitPairs = 1 << 20; ///< type 1 comparisons with more pairs are split into tasks
 
 protected:
 
@@ -196,8 +504,18 @@ protected:
 
     double m_alpha;             ///< girg model parameter, with higher alpha, long edges become less likely
    
-    std::vector<std::mt19937> m_gens; ///< random generators for each thread
-    std::vector<std::uniform_real_distribution<>> m_dists; ///< random distributions for each thread
+    bool m_deterministic;       ///< derive randomness from cell and layer pairs rather than threads (see SpatialTree(bool))
+    int  m_seed;                ///< sampling seed, used to key the counter based engines in deterministic mode
+    int  m_shard;               ///< index of the shard that is sampled (see SpatialTree(bool, int, int))
+    int  m_numShards;           ///< number of shards, 1 samples the whole graph
+    GenerationStats* m_stats = nullptr; ///< statistics to fill or nullptr (see setStatistics)
+
+    std::vector<std::mt19937> m_gens; ///< random generators for each thread, empty for Threshold
+    std::vector<std::vector<double>> m_radii; ///< only for Threshold: \f$(w/\sqrt{W})^{1/D}\f$ for all points of each weight layer in the same order as their weights
+    std::vector<std::vector<double>> m_weight_powers; ///< only for finite alpha: \f$(w/\sqrt{W})^\alpha\f$ in the same layout as #m_radii
+    double m_alphaD;             ///< alpha times D, the exponent of the distance in the connection probability
+    double m_approximationError; ///< upper bound of the relative error of approximateProbability
+    std::vector<TypeIIBound> m_typeII_bounds; ///< only for finite alpha: all type 2 bounds, see typeIIBound
 
 #ifndef NDEBUG
     std::vector<long long> m_type1_checks; ///< number of node pairs per thread that are checked via a type 1 check
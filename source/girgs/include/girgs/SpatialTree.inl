@@ -3,15 +3,46 @@
 namespace girgs {
 
 
-template<unsigned int D>
-void SpatialTree<D>::generateEdges(std::vector<Node>& graph, double alpha, int seed) {
+template<unsigned int D, bool Threshold>
+void SpatialTree<D, Threshold>::generateEdges(std::vector<Node>& graph, double alpha, int seed) {
+    // edges are owned by their source node which is never shared between concurrent threads
+    auto addEdge = [&graph](NodeIndex u, NodeIndex v, int) {
+        graph[u].edges.push_back(&graph[v]);
+    };
+    generateEdges(graph, alpha, seed, addEdge);
+}
+
+
+template<unsigned int D, bool Threshold>
+template<typename EdgeCallback>
+void SpatialTree<D, Threshold>::generateEdges(std::vector<Node>& graph, double alpha, int seed, EdgeCallback& edgeCallback) {
+#ifdef GIRGS_TRACING
+    // trace spans report the edges produced in them, so the tracer counts the edges of each thread
+    auto countingCallback = [&edgeCallback](NodeIndex u, NodeIndex v, int threadId) {
+        Tracer::global().countEdge(threadId);
+        edgeCallback(u, v, threadId);
+    };
+    sampleEdges(graph, alpha, seed, countingCallback);
+#else
+    sampleEdges(graph, alpha, seed, edgeCallback);
+#endif // GIRGS_TRACING
+}
+
+
+template<unsigned int D, bool Threshold>
+template<typename EdgeCallback>
+void SpatialTree<D, Threshold>::sampleEdges(std::vector<Node>& graph, double alpha, int seed, EdgeCallback& edgeCallback) {
+
+    assert(!Threshold || alpha == std::numeric_limits<double>::infinity());
+    auto phaseStart = omp_get_wtime();
 
     // init member and determine min max and sum of weights
     m_alpha = alpha;
+    m_seed = seed >= 0 ? seed : static_cast<int>(std::random_device()() >> 1);
     m_w0 = std::numeric_limits<double>::infinity();
     m_wn = 0.0;
     m_W = 0.0;
-    for(auto i=0u; i<graph.size(); ++i) {
+    for(NodeIndex i=0; i<static_cast<NodeIndex>(graph.size()); ++i) {
         graph[i].index = i;
         m_w0 = std::min(m_w0, graph[i].weight);
         m_wn = std::max(m_wn, graph[i].weight);
@@ -35,22 +66,38 @@ void SpatialTree<D>::generateEdges(std::vector<Node>& graph, double alpha, int s
 
     // sort weights into exponentially growing layers
     {   // block to let weightLayerNodes go out of scope after it was moved away
-        auto weightLayerNodes = std::vector<std::vector<Node*>>(m_layers);
-        for (auto i = 0u; i < graph.size(); ++i)
-            weightLayerNodes[std::log2(graph[i].weight/m_w0)].push_back(&graph[i]);
+        auto weightLayerNodes = std::vector<std::vector<NodeIndex>>(m_layers);
+        for (NodeIndex i = 0; i < static_cast<NodeIndex>(graph.size()); ++i)
+            weightLayerNodes[std::log2(graph[i].weight/m_w0)].push_back(i);
 
         // build spatial structure described in paper
         for (auto layer = 0u; layer < m_layers; ++layer)
-            m_weight_layers.emplace_back(layer, weightLayerTargetLevel(layer), m_helper, std::move(weightLayerNodes[layer]));
+            m_weight_layers.emplace_back(layer, weightLayerTargetLevel(layer), m_helper, weightLayerNodes[layer], graph);
+    }
+
+    // the threshold model compares dist < r_u*r_v with r_u = (w_u/sqrt(W))^(1/D), which is dist^D < w_u*w_v/W
+    if (Threshold)
+        m_radii = scaledWeightPowers(1.0 / D);
+
+    // for finite alpha the connection probability (w_u*w_v/W)^alpha / dist^(alpha*D) is approximated
+    // with per node factors (w_u/sqrt(W))^alpha and FastMath, see approximateProbability
+    m_alphaD = alpha * D;
+    if (!Threshold && alpha != std::numeric_limits<double>::infinity()) {
+        m_weight_powers = scaledWeightPowers(alpha);
+        // relative error of the approximation: exp2 of the error of log2 scaled by alpha*D, the error of exp2,
+        // and generous room for rounding errors of the remaining arithmetic
+        m_approximationError = std::exp2(m_alphaD * FastMath::c_log2Error) * (1.0 + FastMath::c_exp2Error) * (1.0 + 1e-9) - 1.0;
+        initTypeIIBounds();
     }
 
-    // one random generator and distribution for each thread
+    // one random generator for each thread, the threshold model needs no randomness
     const auto num_threads = omp_get_max_threads();
-    m_gens.resize(num_threads);
-    m_dists.resize(num_threads);
-    for (int thread = 0; thread < num_threads; thread++) {
-        m_gens[thread].seed(seed >= 0 ? seed+thread : std::random_device()());
-    } 
+    if (!Threshold) {
+        m_gens.resize(num_threads);
+        for (int thread = 0; thread < num_threads; thread++) {
+            m_gens[thread].seed(seed >= 0 ? seed+thread : std::random_device()());
+        }
+    }
 
 #ifndef NDEBUG
     // ensure that all node pairs are compared either type 1 or type 2
@@ -58,27 +105,79 @@ void SpatialTree<D>::generateEdges(std::vector<Node>& graph, double alpha, int s
     m_type2_checks.resize(num_threads, 0);
 #endif // NDEBUG
 
+    // the time of each phase is only recorded with statistics
+    auto endPhase = [this, &phaseStart](double GenerationStats::* phase) {
+        if (!m_stats)
+            return;
+        const auto now = omp_get_wtime();
+        m_stats->*phase = now - phaseStart;
+        phaseStart = now;
+    };
+    if (m_stats)
+        m_stats->reset(num_threads, m_levels);
+    endPhase(&GenerationStats::buildSeconds);
+
+#ifdef GIRGS_TRACING
+    Tracer::global().prepare(num_threads);
+#endif // GIRGS_TRACING
+
     // sample all edges
-	if (num_threads == 1) { 
+    if (num_threads == 1 && !m_deterministic) {
         // sequential
-		visitCellPair(0, 0, 0);
+        {
+#ifdef GIRGS_TRACING
+            TraceSpan span("sequential", 0, 0, pointsInCell(0, 0));
+#endif // GIRGS_TRACING
+            visitCellPair(0, 0, 0, edgeCallback);
+        }
+        endPhase(&GenerationStats::sequentialSeconds);
+    } else if (m_deterministic || Threshold) {
+        // randomness does not depend on the executing thread, so the whole recursion is split into tasks
+        // the cells are dealt to the shards in a level that must not depend on the number of threads
+        auto costs = std::vector<double>();
+        const auto first_parallel_level = m_numShards > 1 ? chooseFirstParallelLevel(c_deterministicTasks, costs) : 0u;
+        #pragma omp parallel num_threads(num_threads)
+        #pragma omp single
+        visitCell_tasks(0, std::vector<CellIndex>(1, 0), 0, first_parallel_level, edgeCallback);
+        endPhase(&GenerationStats::parallelSeconds);
     } else {
         // parallel see docs for visitCellPair_sequentialStart
-        const auto first_parallel_level = static_cast<unsigned int>(std::ceil(std::log2(4.0*num_threads) / D));
+        // sharding implies the deterministic mode, so all buckets are ours
+        assert(m_numShards == 1);
+        auto costs = std::vector<double>();
+        const auto first_parallel_level = chooseFirstParallelLevel(num_threads, costs);
         const auto parallel_cells = SpatialTreeCoordinateHelper<D>::numCellsInLevel(first_parallel_level);
         const auto first_parallel_cell = SpatialTreeCoordinateHelper<D>::firstCellOfLevel(first_parallel_level);
 
         // saw off recursion before "first_parallel_level" and save all calls that would be made 
-        auto parallel_calls = std::vector<std::vector<unsigned int>>(parallel_cells);
-        visitCellPair_sequentialStart(0, 0, 0, first_parallel_level, parallel_calls);
-        
+        auto parallel_calls = std::vector<std::vector<CellIndex>>(parallel_cells);
+        {
+#ifdef GIRGS_TRACING
+            TraceSpan span("sequential start", 0, 0, pointsInCell(0, 0));
+#endif // GIRGS_TRACING
+            visitCellPair_sequentialStart(0, 0, 0, first_parallel_level, parallel_calls, edgeCallback);
+        }
+        endPhase(&GenerationStats::sequentialSeconds);
+
         // do the collected calls in parallel
-        #pragma omp parallel for schedule(static), num_threads(num_threads) // dynamic scheduling would be better but not reproducible
-        for (int i = 0; i < parallel_cells; ++i) {
+        auto processCell = [&](int i) {
             auto current_cell = first_parallel_cell + i;
+#ifdef GIRGS_TRACING
+            TraceSpan span("bucket", first_parallel_level, current_cell, pointsInCell(current_cell, first_parallel_level));
+#endif // GIRGS_TRACING
             for (auto each : parallel_calls[i])
-                visitCellPair(current_cell, each, first_parallel_level);
+                visitCellPair(current_cell, each, first_parallel_level, edgeCallback);
+        };
+        // dynamic scheduling would be better but not reproducible, so the buckets are assigned by their estimated cost
+        const auto buckets = assignBuckets(costs, num_threads);
+        #pragma omp parallel num_threads(num_threads)
+        {
+            // if the team is smaller than requested, the threads take over the buckets of the missing ones
+            for (auto t = omp_get_thread_num(); t < num_threads; t += omp_get_num_threads())
+                for (auto i : buckets[t])
+                    processCell(i);
         }
+        endPhase(&GenerationStats::parallelSeconds);
     }
 
 #ifndef NDEBUG
@@ -86,32 +185,206 @@ void SpatialTree<D>::generateEdges(std::vector<Node>& graph, double alpha, int s
     auto type1 = std::accumulate(m_type1_checks.begin(), m_type1_checks.end(), 0ll);
     auto type2 = std::accumulate(m_type2_checks.begin(), m_type2_checks.end(), 0ll);
     assert(type1 + type2 == graph.size()*(graph.size() - 1ll)
-        || alpha == std::numeric_limits<double>::infinity()); // we do not compare all nodes in threshold since we skip all type 2 checks
+        || alpha == std::numeric_limits<double>::infinity() // we do not compare all nodes in threshold since we skip all type 2 checks
+        || m_numShards > 1); // the other shards compare the remaining pairs
 #endif // NDEBUG 
 }
 
 
-template<unsigned int D>
-void SpatialTree<D>::visitCellPair(unsigned int cellA, unsigned int cellB, unsigned int level) {
+template<unsigned int D, bool Threshold>
+NodeIndex SpatialTree<D, Threshold>::pointsInCell(CellIndex cell, unsigned int level) const {
+    auto points = NodeIndex(0);
+    for (auto layer = 0u; layer < m_layers; ++layer)
+        if (weightLayerTargetLevel(layer) >= level)
+            points += m_weight_layers[layer].pointsInCell(cell, level);
+    return points;
+}
+
+
+template<unsigned int D, bool Threshold>
+double SpatialTree<D, Threshold>::estimateBucketCost(CellIndex cell, unsigned int level) const {
+    auto points = std::vector<double>(m_layers, 0.0);
+    for (auto layer = 0u; layer < m_layers; ++layer)
+        if (weightLayerTargetLevel(layer) >= level)
+            points[layer] = m_weight_layers[layer].pointsInCell(cell, level);
+
+    auto cost = std::accumulate(points.begin(), points.end(), 0.0);
+    for (auto l = level; l < m_levels; ++l) {
+        const auto touching = std::ldexp(1.0, -static_cast<int>((l - level) * D));
+        for (auto& layer_pair : m_layer_pairs[l])
+            cost += touching * points[layer_pair.first] * points[layer_pair.second];
+    }
+    return cost;
+}
+
+
+template<unsigned int D, bool Threshold>
+unsigned int SpatialTree<D, Threshold>::chooseFirstParallelLevel(int numTasks, std::vector<double>& costs) const {
+    using Helper = SpatialTreeCoordinateHelper<D>;
+    auto level = static_cast<unsigned int>(std::ceil(std::log2(numTasks) / D));
+    const auto deepest = static_cast<unsigned int>(std::ceil(std::log2(static_cast<double>(numTasks) * c_maxBucketsPerTask) / D));
+    for (;; ++level) {
+        const auto cells = Helper::numCellsInLevel(level);
+        const auto first_cell = Helper::firstCellOfLevel(level);
+        costs.resize(cells);
+        for (CellIndex i = 0; i < cells; ++i)
+            costs[i] = estimateBucketCost(first_cell + i, level);
+
+        const auto total = std::accumulate(costs.begin(), costs.end(), 0.0);
+        const auto costliest = *std::max_element(costs.begin(), costs.end());
+        if (level >= deepest || level + 1 >= m_levels || costliest * c_bucketBalance * numTasks <= total)
+            return level;
+    }
+}
+
+
+template<unsigned int D, bool Threshold>
+std::vector<int> SpatialTree<D, Threshold>::bucketsByCost(const std::vector<double>& costs) {
+    auto order = std::vector<int>(costs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&costs](int a, int b) {
+        return costs[a] > costs[b] || (costs[a] == costs[b] && a < b);
+    });
+    return order;
+}
+
+
+template<unsigned int D, bool Threshold>
+std::vector<std::vector<int>> SpatialTree<D, Threshold>::assignBuckets(const std::vector<double>& costs, int numThreads) {
+    // min heap of (load, thread), equal loads pop the smaller thread first
+    using Load = std::pair<double, int>;
+    auto loads = std::priority_queue<Load, std::vector<Load>, std::greater<Load>>();
+    for (int thread = 0; thread < numThreads; ++thread)
+        loads.emplace(0.0, thread);
+
+    auto buckets = std::vector<std::vector<int>>(numThreads);
+    for (auto i : bucketsByCost(costs)) {
+        auto least = loads.top();
+        loads.pop();
+        buckets[least.second].push_back(i);
+        loads.emplace(least.first + costs[i], least.second);
+    }
+    return buckets;
+}
+
+
+template<unsigned int D, bool Threshold>
+bool SpatialTree<D, Threshold>::ownsCell(CellIndex cellA, unsigned int level) const {
+    using Helper = SpatialTreeCoordinateHelper<D>;
+    return m_numShards == 1
+        || static_cast<int>((cellA - Helper::firstCellOfLevel(level)) % static_cast<CellIndex>(m_numShards)) == m_shard;
+}
+
+
+template<unsigned int D, bool Threshold>
+std::vector<std::vector<double>> SpatialTree<D, Threshold>::scaledWeightPowers(double exponent) const {
+    const auto scale = 1.0 / std::sqrt(m_W);
+    auto result = std::vector<std::vector<double>>(m_layers);
+    for (auto layer = 0u; layer < m_layers; ++layer) {
+        const auto& weights = m_weight_layers[layer].weights();
+        auto& powers = result[layer];
+        powers.resize(weights.size());
+        #pragma omp parallel for schedule(static)
+        for (long long k = 0; k < static_cast<long long>(weights.size()); ++k)
+            powers[k] = std::pow(weights[k] * scale, exponent);
+    }
+    return result;
+}
+
+
+template<unsigned int D, bool Threshold>
+void SpatialTree<D, Threshold>::initTypeIIBounds() {
     using Helper = SpatialTreeCoordinateHelper<D>;
+    constexpr auto distances = c_maxTypeIICellDistance - 1;
+    m_typeII_bounds.assign(static_cast<std::size_t>(m_levels) * m_layers * m_layers * distances, TypeIIBound{1.0, 0.0});
+
+    for (auto level = 0u; level < m_levels; ++level) {
+        // type 2 pairs in this level belong to the layer pairs of this and all deeper levels
+        for (auto l = level; l < m_levels; ++l) {
+            for (auto& layer_pair : m_layer_pairs[l]) {
+                const auto i = layer_pair.first;
+                const auto j = layer_pair.second;
+                const auto w_upper_bound = m_w0*(1<<(i+1)) * m_w0*(1<<(j+1)) / m_W;
+
+                // the distance of cells in a torus with 2^level cells per dimension is at most 2^(level-1)
+                const auto maxCellDistance = static_cast<int>(std::min<CellIndex>(c_maxTypeIICellDistance, Helper::numCellsPerDimension(level) / 2));
+                for (auto cellDistance = 2; cellDistance <= maxCellDistance; ++cellDistance) {
+                    // same as SpatialTreeCoordinateHelper::dist(CellIndex, CellIndex, unsigned int)
+                    const auto dist_lower_bound = std::pow((cellDistance - 1) * (1.0 / Helper::numCellsPerDimension(level)), dimension);
+                    assert(dist_lower_bound > w_upper_bound); // in threshold model we would not sample anything
+
+                    auto& bound = m_typeII_bounds[((level * m_layers + i) * m_layers + j) * distances + cellDistance - 2];
+                    bound.probability = std::min(std::pow(w_upper_bound/dist_lower_bound, m_alpha), 1.0);
+                    // 1.0 is no valid prob for a geometric dist and tiny probabilities are skipped completely
+                    bound.invLog1mp = bound.probability < 1.0 && bound.probability > 1e-10 ? 1.0 / std::log(1.0 - bound.probability) : 0.0;
+                }
+            }
+        }
+    }
+}
 
-    auto touching = m_helper.touching(cellA, cellB, level);
+
+template<unsigned int D, bool Threshold>
+const typename SpatialTree<D, Threshold>::TypeIIBound& SpatialTree<D, Threshold>::typeIIBound(int cellDistance, unsigned int level, unsigned int i, unsigned int j) const {
+    // children of touching cells are at most 3 cells apart
+    assert(2 <= cellDistance && cellDistance <= c_maxTypeIICellDistance);
+    assert(level <= partitioningBaseLevel(i, j));
+    return m_typeII_bounds[((level * m_layers + i) * m_layers + j) * (c_maxTypeIICellDistance - 1) + cellDistance - 2];
+}
+
+
+template<unsigned int D, bool Threshold>
+double SpatialTree<D, Threshold>::approximateProbability(double dist, double weightPowerA, double weightPowerB) const {
+    // (w_u*w_v/W)^alpha / dist^(alpha*D) = weightPowerA * weightPowerB * 2^(-alpha*D*log2(dist))
+    // with dist <= 0.5 the exponent is positive, if it is too large for FastMath::exp2 we return NaN
+    const auto exponent = -m_alphaD * FastMath::log2(dist);
+    const auto valid = dist >= std::numeric_limits<double>::min() && exponent <= 1000.0;
+    return valid ? weightPowerA * weightPowerB * FastMath::exp2(valid ? exponent : 0.0) : std::numeric_limits<double>::quiet_NaN();
+}
+
+
+template<unsigned int D, bool Threshold>
+template<typename ExactProbability>
+bool SpatialTree<D, Threshold>::acceptEdge(double uniform, double approximation, ExactProbability exactProbability) const {
+    // the exact probability is within approximation*(1 +- m_approximationError), only in between we need it
+    // comparisons with NaN are false, so an invalid approximation always falls back to the exact probability
+    if (uniform < approximation * (1.0 - m_approximationError))
+        return true;
+    if (uniform >= approximation * (1.0 + m_approximationError))
+        return false;
+    return uniform < exactProbability();
+}
+
+
+template<unsigned int D, bool Threshold>
+template<typename EdgeCallback>
+void SpatialTree<D, Threshold>::visitCellPair(CellIndex cellA, CellIndex cellB, unsigned int level, EdgeCallback& edgeCallback) {
+    using Helper = SpatialTreeCoordinateHelper<D>;
+#ifdef GIRGS_TRACING
+    const auto traced = Tracer::global().tracesLevel(level);
+    TraceSpan span("visitCellPair", level, cellA, traced ? pointsInCell(cellA, level) : 0, traced);
+#endif // GIRGS_TRACING
+    if (m_stats)
+        m_stats->countVisit(omp_get_thread_num(), level);
+
+    const auto cellDistance = m_helper.cellDistance(cellA, cellB, level);
+    const auto touching = cellDistance <= 1;
     if(cellA == cellB || touching) {
 
         // sample all type 1 occurrences with this cell pair
         for(auto& layer_pair : m_layer_pairs[level]){
             assert(partitioningBaseLevel(layer_pair.first, layer_pair.second) == level);
             if(cellA != cellB || layer_pair.first <= layer_pair.second)
-                sampleTypeI(cellA, cellB, level, layer_pair.first, layer_pair.second);
+                sampleTypeI(cellA, cellB, level, layer_pair.first, layer_pair.second, edgeCallback);
         }
 
     } else { // not touching
-		if (m_alpha == std::numeric_limits<double>::infinity())
-			return;
+        if (Threshold || m_alpha == std::numeric_limits<double>::infinity())
+            return;
         // sample all type 2 occurrences with this cell pair
         for(auto l=level; l<m_levels; ++l)
             for(auto& layer_pair : m_layer_pairs[l])
-                sampleTypeII(cellA, cellB, level, layer_pair.first, layer_pair.second);
+                sampleTypeII(cellA, cellB, level, cellDistance, layer_pair.first, layer_pair.second, edgeCallback);
     }
 
     // break if last level reached
@@ -123,33 +396,38 @@ void SpatialTree<D>::visitCellPair(unsigned int cellA, unsigned int cellB, unsig
         // these will be type 1 if a and b touch or type 2 if they don't
         for(auto a = Helper::firstChild(cellA); a<=Helper::lastChild(cellA); ++a)
             for(auto b = cellA == cellB ? a : Helper::firstChild(cellB); b<=Helper::lastChild(cellB); ++b)
-                visitCellPair(a, b, level+1);
+                visitCellPair(a, b, level+1, edgeCallback);
     }
 }
 
 
 
-template<unsigned int D>
-void SpatialTree<D>::visitCellPair_sequentialStart(unsigned int cellA, unsigned int cellB, unsigned int level,
+template<unsigned int D, bool Threshold>
+template<typename EdgeCallback>
+void SpatialTree<D, Threshold>::visitCellPair_sequentialStart(CellIndex cellA, CellIndex cellB, unsigned int level,
                                                    unsigned int first_parallel_level,
-                                                   std::vector<std::vector<unsigned int>> &parallel_calls) {
+                                                   std::vector<std::vector<CellIndex>> &parallel_calls,
+                                                   EdgeCallback& edgeCallback) {
     using Helper = SpatialTreeCoordinateHelper<D>;
+    if (m_stats)
+        m_stats->countVisit(omp_get_thread_num(), level);
 
-    auto touching = m_helper.touching(cellA, cellB, level);
+    const auto cellDistance = m_helper.cellDistance(cellA, cellB, level);
+    const auto touching = cellDistance <= 1;
     if(cellA == cellB || touching) {
         // sample all type 1 occurrences with this cell pair
         for(auto& layer_pair : m_layer_pairs[level]){
             assert(partitioningBaseLevel(layer_pair.first, layer_pair.second) == level);
             if(cellA != cellB || layer_pair.first <= layer_pair.second)
-                sampleTypeI(cellA, cellB, level, layer_pair.first, layer_pair.second);
+                sampleTypeI(cellA, cellB, level, layer_pair.first, layer_pair.second, edgeCallback);
         }
     } else { // not touching
-        if (m_alpha == std::numeric_limits<double>::infinity())
+        if (Threshold || m_alpha == std::numeric_limits<double>::infinity())
             return;
         // sample all type 2 occurrences with this cell pair
         for(auto l=level; l<m_levels; ++l)
             for(auto& layer_pair : m_layer_pairs[l])
-                sampleTypeII(cellA, cellB, level, layer_pair.first, layer_pair.second);
+                sampleTypeII(cellA, cellB, level, cellDistance, layer_pair.first, layer_pair.second, edgeCallback);
     }
 
     // break if last level reached
@@ -164,18 +442,99 @@ void SpatialTree<D>::visitCellPair_sequentialStart(unsigned int cellA, unsigned
                 if(level+1 == first_parallel_level)
                     parallel_calls[a-Helper::firstCellOfLevel(first_parallel_level)].push_back(b);
                 else
-                    visitCellPair_sequentialStart(a, b, level+1, first_parallel_level, parallel_calls);
+                    visitCellPair_sequentialStart(a, b, level+1, first_parallel_level, parallel_calls, edgeCallback);
+            }
+
+    }
+}
+
+
+
+template<unsigned int D, bool Threshold>
+template<typename EdgeCallback>
+void SpatialTree<D, Threshold>::visitCell_tasks(CellIndex cellA, const std::vector<CellIndex>& cellsB, unsigned int level,
+                                                unsigned int first_parallel_level, EdgeCallback& edgeCallback) {
+    using Helper = SpatialTreeCoordinateHelper<D>;
+    // like visitCellPair_sequentialStart above the first parallel level and like the buckets in it
+    if (level == first_parallel_level && !ownsCell(cellA, level))
+        return;
+    const auto owned = level > first_parallel_level || ownsCell(cellA, level);
+#ifdef GIRGS_TRACING
+    // the cells that are visited by the task of their parent are only traced in the requested levels
+    const auto points = pointsInCell(cellA, level);
+    TraceSpan span("task", level, cellA, points, level == 0 || points >= c_taskMinPoints || Tracer::global().tracesLevel(level));
+#endif // GIRGS_TRACING
+
+    // same as visitCellPair for each pair, but the children are collected for all pairs
+    auto child_calls = std::vector<std::vector<CellIndex>>(level + 1 < m_levels ? Helper::numChildren() : 0);
+    for (auto cellB : cellsB) {
+        if (m_stats)
+            m_stats->countVisit(omp_get_thread_num(), level);
+
+        const auto cellDistance = m_helper.cellDistance(cellA, cellB, level);
+        const auto touching = cellDistance <= 1;
+        if (cellA == cellB || touching) {
+            // sample all type 1 occurrences with this cell pair
+            for (auto& layer_pair : m_layer_pairs[level]) {
+                assert(partitioningBaseLevel(layer_pair.first, layer_pair.second) == level);
+                if (owned && (cellA != cellB || layer_pair.first <= layer_pair.second))
+                    sampleTypeI(cellA, cellB, level, layer_pair.first, layer_pair.second, edgeCallback);
             }
+        } else { // not touching
+            if (owned && !Threshold && m_alpha != std::numeric_limits<double>::infinity())
+                // sample all type 2 occurrences with this cell pair
+                for (auto l = level; l < m_levels; ++l)
+                    for (auto& layer_pair : m_layer_pairs[l])
+                        sampleTypeII(cellA, cellB, level, cellDistance, layer_pair.first, layer_pair.second, edgeCallback);
+            continue;
+        }
+
+        if (child_calls.empty()) // if we are at the last level we don't need recursive calls
+            continue;
+        for (auto a = Helper::firstChild(cellA); a <= Helper::lastChild(cellA); ++a)
+            for (auto b = cellA == cellB ? a : Helper::firstChild(cellB); b <= Helper::lastChild(cellB); ++b)
+                child_calls[a - Helper::firstChild(cellA)].push_back(b);
+    }
 
+    // the children only produce edges of their own nodes, so they are independent of each other
+    auto* callback = &edgeCallback; // a reference would be copied into the task
+    for (auto k = 0u; k < child_calls.size(); ++k) {
+        if (child_calls[k].empty())
+            continue;
+        const auto child = Helper::firstChild(cellA) + k;
+        if (pointsInCell(child, level + 1) < c_taskMinPoints) {
+            visitCell_tasks(child, child_calls[k], level + 1, first_parallel_level, edgeCallback);
+            continue;
+        }
+        auto calls = std::move(child_calls[k]);
+        #pragma omp task firstprivate(child, calls)
+        visitCell_tasks(child, calls, level + 1, first_parallel_level, *callback);
     }
 }
 
 
+template<unsigned int D, bool Threshold>
+template<typename EdgeCallback>
+void SpatialTree<D, Threshold>::sampleTypeI(
+        CellIndex cellA, CellIndex cellB, unsigned int level,
+        unsigned int i, unsigned int j, EdgeCallback& edgeCallback)
+{
+    if (Threshold) {
+        sampleTypeIThreshold(cellA, cellB, level, i, j, edgeCallback);
+    } else if (m_deterministic) {
+        auto gen = CounterBasedEngine(m_seed, cellA, cellB, i, j);
+        sampleTypeI(cellA, cellB, level, i, j, gen, edgeCallback);
+    } else {
+        sampleTypeI(cellA, cellB, level, i, j, m_gens[omp_get_thread_num()], edgeCallback);
+    }
+}
+
 
-template<unsigned int D>
-void SpatialTree<D>::sampleTypeI(
-        unsigned int cellA, unsigned int cellB, unsigned int level,
-        unsigned int i, unsigned int j)
+template<unsigned int D, bool Threshold>
+template<typename EdgeCallback, typename Engine>
+void SpatialTree<D, Threshold>::sampleTypeI(
+        CellIndex cellA, CellIndex cellB, unsigned int level,
+        unsigned int i, unsigned int j, Engine& gen, EdgeCallback& edgeCallback)
 {
 
     auto sizeV_i_A = m_weight_layers[i].pointsInCell(cellA, level);
@@ -183,49 +542,196 @@ void SpatialTree<D>::sampleTypeI(
 	if (sizeV_i_A == 0 || sizeV_j_B == 0)
 		return;
 
+    if (m_stats)
+        m_stats->threads[omp_get_thread_num()].typeIPairs += (cellA == cellB && i == j)
+            ? static_cast<std::uint64_t>(sizeV_i_A) * (sizeV_i_A-1) / 2 // all pairs in AxA without {v,v}
+            : static_cast<std::uint64_t>(sizeV_i_A) * sizeV_j_B;        // all pairs in AxB
+
 #ifndef NDEBUG
     m_type1_checks[omp_get_thread_num()] += (cellA == cellB && i == j) 
         ? sizeV_i_A * (sizeV_i_A-1)  // all pairs in AxA without {v,v}
         : sizeV_i_A * sizeV_j_B * 2; // all pairs in AxB and BxA
 #endif // NDEBUG
 
-	Node* const * firstA = m_weight_layers[i].firstPointPointer(cellA, level);
-	Node* const * firstB = m_weight_layers[j].firstPointPointer(cellB, level);
-
-    for(int kA=0; kA<sizeV_i_A; ++kA){
-        for (int kB =(cellA == cellB && i==j ? kA+1 : 0); kB<sizeV_j_B; ++kB) {
-            Node* nodeInA = *(firstA+kA);
-            Node* nodeInB = *(firstB+kB);
-			//Node* nodeInA = m_weight_layers[i].kthPoint(cellA, level, kA);
-			//Node* nodeInB = m_weight_layers[j].kthPoint(cellB, level, kB);
-
-			// pointer magic gives same results
-			assert(nodeInA == m_weight_layers[i].kthPoint(cellA, level, kA));
-			assert(nodeInB == m_weight_layers[j].kthPoint(cellB, level, kB));
-
-            // points are in correct cells
-            assert(cellA == m_helper.cellForPoint(nodeInA->coord, level));
-            assert(cellB == m_helper.cellForPoint(nodeInB->coord, level));
-
-            // points are in correct weight layer
-            assert(i == static_cast<unsigned int>(std::log2(nodeInA->weight/m_w0)));
-            assert(j == static_cast<unsigned int>(std::log2(nodeInB->weight/m_w0)));
-
-            assert(nodeInA->index != nodeInB->index);
-            auto dist = m_helper.dist(nodeInA->coord, nodeInB->coord);
-            if(checkEdgeExplicit(dist, nodeInA->weight, nodeInB->weight)){
-                nodeInA->edges.push_back(nodeInB);
-                //nodeInB->edges.push_back(nodeInA);
+    const auto& layerA = m_weight_layers[i];
+    const auto& layerB = m_weight_layers[j];
+    const auto firstA = layerA.firstPointInCell(cellA, level);
+    const auto firstB = layerB.firstPointInCell(cellB, level);
+
+    // the points of both cells are contiguous in the point arrays of their layers
+    const auto* posA = layerA.positions().data() + firstA;
+    const auto* posB = layerB.positions().data() + firstB;
+    const auto* weightA = layerA.weights().data() + firstA;
+    const auto* weightB = layerB.weights().data() + firstB;
+    const auto* indexA = layerA.indices().data() + firstA;
+    const auto* indexB = layerB.indices().data() + firstB;
+    // the threshold model has no weight powers, the kernel does not read them then
+    const auto* powerA = m_weight_powers.empty() ? weightA : m_weight_powers[i].data() + firstA;
+    const auto* powerB = m_weight_powers.empty() ? weightB : m_weight_powers[j].data() + firstB;
+
+    // the rows [beginA, endA) draw one random number per pair in the order of the pairs
+    auto sampleRows = [&](NodeIndex beginA, NodeIndex endA, Engine& rowGen) {
+        const auto threadId = omp_get_thread_num();
+        for(NodeIndex kA=beginA; kA<endA; ++kA){
+            // points are in correct cell and weight layer
+            assert(cellA == m_helper.cellForPoint(posA[kA], level));
+            assert(i == static_cast<unsigned int>(std::log2(weightA[kA]/m_w0)));
+
+            for (NodeIndex kB =(cellA == cellB && i==j ? kA+1 : 0); kB<sizeV_j_B; kB += c_typeIBlockSize) {
+                const auto size = static_cast<int>(std::min<NodeIndex>(c_typeIBlockSize, sizeV_j_B - kB));
+#ifndef NDEBUG
+                for (auto k = kB; k < kB + size; ++k) {
+                    assert(cellB == m_helper.cellForPoint(posB[k], level));
+                    assert(j == static_cast<unsigned int>(std::log2(weightB[k]/m_w0)));
+                    assert(indexA[kA] != indexB[k]);
+                }
+#endif // NDEBUG
+                sampleTypeIBlock(posA[kA], weightA[kA], powerA[kA], indexA[kA], posB + kB, weightB + kB, powerB + kB, indexB + kB, size, rowGen, edgeCallback, threadId);
+            }
+        }
+    };
+
+    const auto sameSet = cellA == cellB && i == j;
+    const auto pairs = sameSet
+        ? static_cast<std::uint64_t>(sizeV_i_A) * (sizeV_i_A-1) / 2
+        : static_cast<std::uint64_t>(sizeV_i_A) * sizeV_j_B;
+    if (!splitsTypeI(pairs)) {
+        sampleRows(0, sizeV_i_A, gen);
+        return;
+    }
+
+    // each block continues the random numbers where the rows before it would have stopped
+    auto sampleBlock = [&](NodeIndex beginA, NodeIndex endA, std::uint64_t skippedPairs) {
+        auto blockGen = gen;
+        blockGen.discard(skippedPairs);
+        sampleRows(beginA, endA, blockGen);
+    };
+    sampleTypeIRowBlocks(sizeV_i_A, sizeV_j_B, sameSet, sampleBlock);
+    gen.discard(pairs);
+}
+
+
+template<unsigned int D, bool Threshold>
+template<typename EdgeCallback>
+void SpatialTree<D, Threshold>::sampleTypeIThreshold(
+        CellIndex cellA, CellIndex cellB, unsigned int level,
+        unsigned int i, unsigned int j, EdgeCallback& edgeCallback)
+{
+    assert(Threshold);
+
+    auto sizeV_i_A = m_weight_layers[i].pointsInCell(cellA, level);
+    auto sizeV_j_B = m_weight_layers[j].pointsInCell(cellB, level);
+    if (sizeV_i_A == 0 || sizeV_j_B == 0)
+        return;
+
+    if (m_stats)
+        m_stats->threads[omp_get_thread_num()].typeIPairs += (cellA == cellB && i == j)
+            ? static_cast<std::uint64_t>(sizeV_i_A) * (sizeV_i_A-1) / 2 // all pairs in AxA without {v,v}
+            : static_cast<std::uint64_t>(sizeV_i_A) * sizeV_j_B;        // all pairs in AxB
+
+#ifndef NDEBUG
+    m_type1_checks[omp_get_thread_num()] += (cellA == cellB && i == j)
+        ? sizeV_i_A * (sizeV_i_A-1)  // all pairs in AxA without {v,v}
+        : sizeV_i_A * sizeV_j_B * 2; // all pairs in AxB and BxA
+#endif // NDEBUG
+
+    const auto& layerA = m_weight_layers[i];
+    const auto& layerB = m_weight_layers[j];
+    const auto firstA = layerA.firstPointInCell(cellA, level);
+    const auto firstB = layerB.firstPointInCell(cellB, level);
+
+    const auto* posA = layerA.positions().data() + firstA;
+    const auto* posB = layerB.positions().data() + firstB;
+    const auto* radiusA = m_radii[i].data() + firstA;
+    const auto* radiusB = m_radii[j].data() + firstB;
+    const auto* indexA = layerA.indices().data() + firstA;
+    const auto* indexB = layerB.indices().data() + firstB;
+
+    // there are no random numbers, so the rows need not know the pairs before them
+    auto sampleRows = [&](NodeIndex beginA, NodeIndex endA, std::uint64_t) {
+        const auto threadId = omp_get_thread_num();
+        bool edge[c_typeIBlockSize];
+        for(NodeIndex kA=beginA; kA<endA; ++kA){
+            assert(cellA == m_helper.cellForPoint(posA[kA], level));
+
+            for (NodeIndex kB =(cellA == cellB && i==j ? kA+1 : 0); kB<sizeV_j_B; kB += c_typeIBlockSize) {
+                const auto size = static_cast<int>(std::min<NodeIndex>(c_typeIBlockSize, sizeV_j_B - kB));
+
+                #pragma omp simd
+                for (int k = 0; k < size; ++k)
+                    edge[k] = SpatialTreeCoordinateHelper<D>::dist(posA[kA], posB[kB + k]) < radiusA[kA] * radiusB[kB + k];
+
+                for (int k = 0; k < size; ++k) {
+                    assert(cellB == m_helper.cellForPoint(posB[kB + k], level));
+                    assert(indexA[kA] != indexB[kB + k]);
+                    if (edge[k])
+                        edgeCallback(indexA[kA], indexB[kB + k], threadId);
+                }
             }
         }
+    };
+
+    const auto sameSet = cellA == cellB && i == j;
+    const auto pairs = sameSet
+        ? static_cast<std::uint64_t>(sizeV_i_A) * (sizeV_i_A-1) / 2
+        : static_cast<std::uint64_t>(sizeV_i_A) * sizeV_j_B;
+    if (splitsTypeI(pairs))
+        sampleTypeIRowBlocks(sizeV_i_A, sizeV_j_B, sameSet, sampleRows);
+    else
+        sampleRows(0, sizeV_i_A, 0);
+}
+
+
+template<unsigned int D, bool Threshold>
+bool SpatialTree<D, Threshold>::splitsTypeI(std::uint64_t pairs) const {
+    return (m_deterministic || Threshold) && pairs >= c_typeISplitPairs && omp_in_parallel();
+}
+
+
+template<unsigned int D, bool Threshold>
+template<typename SampleRows>
+void SpatialTree<D, Threshold>::sampleTypeIRowBlocks(NodeIndex sizeA, NodeIndex sizeB, bool sameSet, SampleRows& sampleRows) const {
+    // rows of the same set get shorter, so their blocks are cut by the pairs in them
+    auto pairsBefore = [sizeA, sizeB, sameSet](NodeIndex row) {
+        const auto k = static_cast<std::uint64_t>(row);
+        return sameSet ? k * sizeA - k * (k+1) / 2 : k * sizeB;
+    };
+
+    auto* rows = &sampleRows; // a reference would be copied into the task
+    for (NodeIndex beginA = 0; beginA < sizeA; ) {
+        const auto skippedPairs = pairsBefore(beginA);
+        auto endA = beginA + 1;
+        while (endA < sizeA && pairsBefore(endA) - skippedPairs < c_typeISplitPairs)
+            ++endA;
+        #pragma omp task firstprivate(beginA, endA, skippedPairs)
+        (*rows)(beginA, endA, skippedPairs);
+        beginA = endA;
+    }
+    // the caller continues with other pairs of the same source nodes
+    #pragma omp taskwait
+}
+
+
+template<unsigned int D, bool Threshold>
+template<typename EdgeCallback>
+void SpatialTree<D, Threshold>::sampleTypeII(
+        CellIndex cellA, CellIndex cellB, unsigned int level, int cellDistance,
+        unsigned int i, unsigned int j, EdgeCallback& edgeCallback)
+{
+    if (m_deterministic) {
+        auto gen = CounterBasedEngine(m_seed, cellA, cellB, i, j);
+        sampleTypeII(cellA, cellB, level, cellDistance, i, j, gen, edgeCallback);
+    } else {
+        sampleTypeII(cellA, cellB, level, cellDistance, i, j, m_gens[omp_get_thread_num()], edgeCallback);
     }
 }
 
 
-template<unsigned int D>
-void SpatialTree<D>::sampleTypeII(
-        unsigned int cellA, unsigned int cellB, unsigned int level,
-        unsigned int i, unsigned int j)
+template<unsigned int D, bool Threshold>
+template<typename EdgeCallback, typename Engine>
+void SpatialTree<D, Threshold>::sampleTypeII(
+        CellIndex cellA, CellIndex cellB, unsigned int level, int cellDistance,
+        unsigned int i, unsigned int j, Engine& gen, EdgeCallback& edgeCallback)
 {
     long long sizeV_i_A = m_weight_layers[i].pointsInCell(cellA, level);
     long long sizeV_j_B = m_weight_layers[j].pointsInCell(cellB, level);
@@ -233,15 +739,13 @@ void SpatialTree<D>::sampleTypeII(
         return;
 
     // get upper bound for probability
-    auto w_upper_bound = m_w0*(1<<(i+1)) * m_w0*(1<<(j+1)) / m_W;
-    auto dist_lower_bound = std::pow(m_helper.dist(cellA, cellB, level), dimension);
-    auto max_connection_prob = std::min(std::pow(w_upper_bound/dist_lower_bound, m_alpha), 1.0);
-    assert(dist_lower_bound > w_upper_bound); // in threshold model we would not sample anything
+    const auto& bound = typeIIBound(cellDistance, level, i, j);
+    const auto max_connection_prob = bound.probability;
+    assert(cellDistance == m_helper.cellDistance(cellA, cellB, level));
 
     // if we must sample all pairs we treat this as type 1 sampling
-    // also, 1.0 is no valid prob for a geometric dist (see c++ std)
     if(max_connection_prob == 1.0){
-        sampleTypeI(cellA, cellB, level, i, j);
+        sampleTypeI(cellA, cellB, level, i, j, gen, edgeCallback);
         return;
     }
 
@@ -252,41 +756,71 @@ void SpatialTree<D>::sampleTypeII(
     if(max_connection_prob <= 1e-10)
         return;
 
-    // init geometric distribution
     auto threadID = omp_get_thread_num();
-    auto& gen = m_gens[threadID];
-    auto geo = std::geometric_distribution<unsigned long long>(max_connection_prob);
-
-    for (auto r = geo(gen); r < sizeV_i_A * sizeV_j_B; r += 1 + geo(gen)) {
+    auto uniformDist = std::uniform_real_distribution<>();
+
+    // number of pairs to skip until the next candidate, this draws the same random numbers as
+    // std::geometric_distribution(max_connection_prob) but does not need a log and a division per setup and draw
+    auto skip = [&]() {
+        return std::floor(std::log(1.0 - uniformDist(gen)) * bound.invLog1mp);
+    };
+
+    const auto& layerA = m_weight_layers[i];
+    const auto& layerB = m_weight_layers[j];
+    const auto firstA = layerA.firstPointInCell(cellA, level);
+    const auto firstB = layerB.firstPointInCell(cellB, level);
+
+    // the pair index is kept as double since skips may be arbitrarily large
+    const auto numPairs = static_cast<double>(sizeV_i_A * sizeV_j_B);
+    auto candidates = std::uint64_t(0);
+    auto accepted = std::uint64_t(0);
+    for (auto r = skip(); r < numPairs; r += 1.0 + skip()) {
+        ++candidates;
         // determine the r-th pair
-        Node* nodeInA = m_weight_layers[i].kthPoint(cellA, level, r%sizeV_i_A);
-        Node* nodeInB = m_weight_layers[j].kthPoint(cellB, level, r/sizeV_i_A);
+        const auto pair = static_cast<long long>(r);
+        const auto kA = firstA + static_cast<NodeIndex>(pair%sizeV_i_A);
+        const auto kB = firstB + static_cast<NodeIndex>(pair/sizeV_i_A);
+        const auto& posA = layerA.positions()[kA];
+        const auto& posB = layerB.positions()[kB];
+        const auto weightA = layerA.weights()[kA];
+        const auto weightB = layerB.weights()[kB];
 
         // points are in correct cells
-        assert(cellA == m_helper.cellForPoint(nodeInA->coord, level));
-        assert(cellB == m_helper.cellForPoint(nodeInB->coord, level));
+        assert(cellA == m_helper.cellForPoint(posA, level));
+        assert(cellB == m_helper.cellForPoint(posB, level));
 
         // points are in correct weight layer
-        assert(i == static_cast<unsigned int>(std::log2(nodeInA->weight/m_w0)));
-        assert(j == static_cast<unsigned int>(std::log2(nodeInB->weight/m_w0)));
-
-        // get actual connection probability
-        auto w = nodeInA->weight*nodeInB->weight/m_W;
-        auto d = std::pow(m_helper.dist(nodeInA->coord, nodeInB->coord), dimension);
-        auto connection_prob = std::min(std::pow(w/d, m_alpha), 1.0);
-        assert(w < w_upper_bound);
-        assert(d >= dist_lower_bound);
-
-        if(m_dists[threadID](gen) < connection_prob/max_connection_prob) {
-            nodeInA->edges.push_back(nodeInB);
-            //nodeInB->edges.push_back(nodeInA);
+        assert(i == static_cast<unsigned int>(std::log2(weightA/m_w0)));
+        assert(j == static_cast<unsigned int>(std::log2(weightB/m_w0)));
+
+        // accept with probability connection_prob/max_connection_prob, the exact connection_prob is only
+        // computed if the approximation is not precise enough to decide
+        const auto pointDist = m_helper.dist(posA, posB);
+        const auto approximation = approximateProbability(pointDist, m_weight_powers[i][kA], m_weight_powers[j][kB]) / max_connection_prob;
+        auto exactProbability = [&]() {
+            auto w = weightA*weightB/m_W;
+            auto d = std::pow(pointDist, dimension);
+            auto connection_prob = std::min(std::pow(w/d, m_alpha), 1.0);
+            assert(w < m_w0*(1<<(i+1)) * m_w0*(1<<(j+1)) / m_W);
+            assert(d >= std::pow(m_helper.dist(cellA, cellB, level), dimension));
+            return connection_prob/max_connection_prob;
+        };
+
+        if(acceptEdge(uniformDist(gen), approximation, exactProbability)) {
+            edgeCallback(layerA.indices()[kA], layerB.indices()[kB], threadID);
+            ++accepted;
         }
     }
+
+    if (m_stats) {
+        m_stats->threads[threadID].typeIICandidates += candidates;
+        m_stats->threads[threadID].typeIIAccepted += accepted;
+    }
 }
 
 
-template<unsigned int D>
-unsigned int SpatialTree<D>::weightLayerTargetLevel(int layer) const {
+template<unsigned int D, bool Threshold>
+unsigned int SpatialTree<D, Threshold>::weightLayerTargetLevel(int layer) const {
     // -1 coz w0 is the upper bound for layer 0 in paper and our layers are shifted by -1
     auto result = std::max((m_baseLevelConstant - layer - 1) / (int)D, 0);
 #ifndef NDEBUG
@@ -304,8 +838,8 @@ unsigned int SpatialTree<D>::weightLayerTargetLevel(int layer) const {
 }
 
 
-template<unsigned int D>
-unsigned int SpatialTree<D>::partitioningBaseLevel(int layer1, int layer2) const {
+template<unsigned int D, bool Threshold>
+unsigned int SpatialTree<D, Threshold>::partitioningBaseLevel(int layer1, int layer2) const {
 
     // we do the computation on signed ints but cast back after the max with 0
     // m_baseLevelConstant is just log(W/w0^2)
@@ -326,20 +860,50 @@ unsigned int SpatialTree<D>::partitioningBaseLevel(int layer1, int layer2) const
 }
 
 
-template<unsigned int D>
-bool SpatialTree<D>::checkEdgeExplicit(double dist, double w1, double w2) {
-    auto w_term = w1*w2/m_W;
-	auto d_term = 1.0; // dist^D
-	for (int i = 0; i < D; ++i)
-		d_term *= dist;
-    if(m_alpha == std::numeric_limits<double>::infinity())
-        return d_term < w_term;
+template<unsigned int D, bool Threshold>
+constexpr int SpatialTree<D, Threshold>::c_typeIBlockSize;
 
-    auto edge_prob = std::min(std::pow(w_term/d_term, m_alpha), 1.0);
-    auto threadID = omp_get_thread_num();
-    return m_dists[threadID](m_gens[threadID]) < edge_prob;
-}
+template<unsigned int D, bool Threshold>
+template<typename EdgeCallback, typename Engine>
+void SpatialTree<D, Threshold>::sampleTypeIBlock(
+        const std::array<double, D>& posA, double weightA, double powerA, NodeIndex indexA,
+        const std::array<double, D>* posB, const double* weightB, const double* powerB, const NodeIndex* indexB, int size,
+        Engine& gen, EdgeCallback& edgeCallback, int threadId)
+{
+    using Helper = SpatialTreeCoordinateHelper<D>;
+    assert(0 < size && size <= c_typeIBlockSize);
 
+    // the threshold model of the generic tree compares w_term against d_term
+    if (m_alpha == std::numeric_limits<double>::infinity()) {
+        for (int k = 0; k < size; ++k)
+            if (Helper::powD(Helper::dist(posA, posB[k])) < weightA * weightB[k] / m_W)
+                edgeCallback(indexA, indexB[k], threadId);
+        return;
+    }
+
+    double dist[c_typeIBlockSize];
+    double approximation[c_typeIBlockSize];
+    double uniform[c_typeIBlockSize];
+
+    #pragma omp simd
+    for (int k = 0; k < size; ++k) {
+        dist[k] = Helper::dist(posA, posB[k]);
+        approximation[k] = approximateProbability(dist[k], powerA, powerB[k]);
+    }
+
+    // one uniform per pair in the same order as the pairs
+    auto uniformDist = std::uniform_real_distribution<>();
+    for (int k = 0; k < size; ++k)
+        uniform[k] = uniformDist(gen);
+
+    for (int k = 0; k < size; ++k) {
+        auto exactProbability = [&]() {
+            return std::min(std::pow((weightA * weightB[k] / m_W) / Helper::powD(dist[k]), m_alpha), 1.0);
+        };
+        if (acceptEdge(uniform[k], approximation[k], exactProbability))
+            edgeCallback(indexA, indexB[k], threadId);
+    }
+}
 
 
 } // namespace girgs
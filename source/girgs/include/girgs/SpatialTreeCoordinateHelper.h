@@ -3,7 +3,14 @@
 
 #include <vector>
 #include <array>
+#include <algorithm>
+#include <cmath>
 #include <cassert>
+#include <cstdint>
+#include <type_traits>
+
+#include <girgs/BitManipulation.h>
+#include <girgs/IndexTypes.h>
 
 
 namespace girgs {
@@ -14,39 +21,77 @@ class SpatialTreeCoordinateHelper
 {
 public:
 
+    // signed integer type of cell coordinates within a level
+    using CellCoord = std::make_signed<CellIndex>::type;
+
     // static helper functions
     // the total number of cells on all levels {0..(L-1)}
     // $\sum_{i=0}^{L-1} 2^{DL} = \frac{2^{DL}-1}{2^D-1}
-    static constexpr unsigned int numCellsInLevel(unsigned int level) noexcept { return 1u<<(D*level); }
-    static constexpr unsigned int firstCellOfLevel(unsigned int level) noexcept { return ((1u<<(D*level))-1)/((1<<D)-1); }
+    static constexpr CellIndex numCellsInLevel(unsigned int level) noexcept { return CellIndex(1)<<(D*level); }
+    static constexpr CellIndex numCellsPerDimension(unsigned int level) noexcept { return CellIndex(1)<<level; }
+    static constexpr CellIndex firstCellOfLevel(unsigned int level) noexcept { return ((CellIndex(1)<<(D*level))-1)/((1<<D)-1); }
 
-    static constexpr unsigned int parent(unsigned int cell) noexcept { return (cell-1)/(1<<D); }
-    static constexpr unsigned int firstChild(unsigned int cell) noexcept { return (1<<D)*cell+1; }
-    static constexpr unsigned int lastChild(unsigned int cell) noexcept { return firstChild(cell) + numChildren() - 1; }
-    static constexpr unsigned int numChildren() noexcept { return 1u<<D; }
+    static constexpr CellIndex parent(CellIndex cell) noexcept { return (cell-1)/(1<<D); }
+    static constexpr CellIndex firstChild(CellIndex cell) noexcept { return (1<<D)*cell+1; }
+    static constexpr CellIndex lastChild(CellIndex cell) noexcept { return firstChild(cell) + numChildren() - 1; }
+    static constexpr CellIndex numChildren() noexcept { return CellIndex(1)<<D; }
 
     SpatialTreeCoordinateHelper() = default;
     explicit SpatialTreeCoordinateHelper(unsigned int levels);
 
-    std::array<std::pair<double,double>, D> bounds(unsigned int cell, unsigned int level) const;
-    unsigned int cellForPoint(std::vector<double>& point, unsigned int targetLevel) const;
-
-    bool touching(unsigned int cellA, unsigned int cellB, unsigned int level) const;
+    // integer coordinates of a cell within its level, computed from the Morton code of the cell
+    static std::array<CellCoord, D> cellCoords(CellIndex cell, unsigned int level) noexcept;
+
+    std::array<std::pair<double,double>, D> bounds(CellIndex cell, unsigned int level) const;
+    CellIndex cellForPoint(const std::vector<double>& point, unsigned int targetLevel) const;
+    CellIndex cellForPoint(const std::array<double, D>& point, unsigned int targetLevel) const;
+
+    /**
+     * @brief
+     *  Computes cellForPoint for many points at once.
+     *
+     * @param count
+     *  Number of points.
+     * @param point
+     *  point(i) returns the i-th point as a container with D coordinates (std::vector or std::array).
+     * @param targetLevel
+     *  The level of the cells.
+     * @param cells
+     *  Output, cells[i] is the cell of the i-th point. Must have space for count entries.
+     */
+    template<typename PointAccess>
+    void cellsForPoints(std::size_t count, PointAccess point, unsigned int targetLevel, CellIndex* cells) const;
+
+    bool touching(CellIndex cellA, CellIndex cellB, unsigned int level) const;
+
+    // chebyshev distance of two cells of the same level on the torus in units of cells, cells touch iff it is at most 1
+    CellCoord cellDistance(CellIndex cellA, CellIndex cellB, unsigned int level) const;
 
     // implements the chebyshev distance metric (L_\infty)
-    static double dist(std::vector<double>& a, std::vector<double>& b);
+    static double dist(const std::vector<double>& a, const std::vector<double>& b);
+    static double dist(const std::array<double, D>& a, const std::array<double, D>& b);
+
+    // returns x^D, like dist(array, array) it is unrolled at compile time such that loops over many points can be vectorized
+    static double powD(double x) { return powUpTo(x, std::integral_constant<unsigned int, D>()); }
 
     // returns a lower bound for the distance of two points in these cells
-    double dist(unsigned int cellA, unsigned int cellB, unsigned int level) const;
+    double dist(CellIndex cellA, CellIndex cellB, unsigned int level) const;
 
 
     unsigned int levels() const { return m_levels; }
 
 
 protected:
-    unsigned int m_levels = 0;
+    // maximum of the torus distances in the first K dimensions and x^K, unrolled by recursion over K
+    static double distUpTo(const std::array<double, D>&, const std::array<double, D>&, std::integral_constant<unsigned int, 0>) { return 0.0; }
+    template<unsigned int K>
+    static double distUpTo(const std::array<double, D>& a, const std::array<double, D>& b, std::integral_constant<unsigned int, K>);
+
+    static double powUpTo(double, std::integral_constant<unsigned int, 0>) { return 1.0; }
+    template<unsigned int K>
+    static double powUpTo(double x, std::integral_constant<unsigned int, K>) { return x * powUpTo(x, std::integral_constant<unsigned int, K-1>()); }
 
-    std::vector<std::array<int, D>> m_coords;       // cell index to coord
+    unsigned int m_levels = 0;
 };
 
 
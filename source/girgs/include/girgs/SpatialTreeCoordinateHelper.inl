@@ -5,82 +5,105 @@ namespace girgs {
 template<unsigned int D>
 SpatialTreeCoordinateHelper<D>::SpatialTreeCoordinateHelper(unsigned int levels)
     : m_levels(levels)
-    , m_coords(firstCellOfLevel(levels))
 {
+    // the level local index of a cell in the deepest level has to fit into the Morton code
+    assert(levels == 0 || D*(levels-1) < 8*sizeof(CellIndex));
+}
 
-    // calculate coords // TODO find implicit way to get from index to coords and back
-
-    m_coords[0].fill(0); // first cell has [0]^D
-    for(auto l=1u; l<levels; ++l) {
-        for(auto cell = firstCellOfLevel(l); cell < firstCellOfLevel(l+1); ++cell) {
-            m_coords[cell] = m_coords[parent(cell)];
-            auto bitmask = ((cell-1)&(numChildren()-1)); // & is unnecessary but removes all but the last D bits
-            for(auto d=0u; d<D; ++d) { // check orientation to parent in all dimensions with d-th bit in bitmask
-                m_coords[cell][d] *= 2; // every level doubles each dimension
-                m_coords[cell][d] += static_cast<bool>(bitmask&(1<<d)); // add 1 if we are "right" of parent in dimension d
-            }
-        }
-    }
+
+template<unsigned int D>
+std::array<typename SpatialTreeCoordinateHelper<D>::CellCoord, D> SpatialTreeCoordinateHelper<D>::cellCoords(CellIndex cell, unsigned int level) noexcept {
+    assert(firstCellOfLevel(level) <= cell && cell < firstCellOfLevel(level+1)); // cell is from correct level
+
+    // the level local index of a cell is the Morton code of its integer coordinates
+    const auto coords = BitManipulation::Default<D, CellIndex>::extract(cell - firstCellOfLevel(level));
+    std::array<CellCoord, D> result;
+    for(auto d=0u; d<D; ++d)
+        result[d] = static_cast<CellCoord>(coords[d]);
+    return result;
 }
 
 
 template<unsigned int D>
-std::array<std::pair<double, double>, D> SpatialTreeCoordinateHelper<D>::bounds(unsigned int cell, unsigned int level) const {
-    auto diameter = 1.0 / (1<<level);
+std::array<std::pair<double, double>, D> SpatialTreeCoordinateHelper<D>::bounds(CellIndex cell, unsigned int level) const {
+    const auto coords = cellCoords(cell, level);
+    auto diameter = 1.0 / numCellsPerDimension(level);
     auto result = std::array<std::pair<double, double>, D>();
     for(auto d=0u; d<D; ++d)
-        result[d]= { m_coords[cell][d]*diameter, (m_coords[cell][d]+1)*diameter };
+        result[d]= { coords[d]*diameter, (coords[d]+1)*diameter };
     return result;
 }
 
 
 template<unsigned int D>
-unsigned int SpatialTreeCoordinateHelper<D>::cellForPoint(std::vector<double>& point, unsigned int targetLevel) const {
-    // calculate coords
+CellIndex SpatialTreeCoordinateHelper<D>::cellForPoint(const std::vector<double>& point, unsigned int targetLevel) const {
     assert(point.size() == D);
-    auto diameter = static_cast<double>(1 << targetLevel);
-
-    std::array<int, D> coords;
-	for (auto d = 0u; d < D; ++d)
-        coords[d] = static_cast<unsigned int>(point[d] * diameter);
-
-	/*
-	 * We now interleave the bits of the coordinates, let X[i,j] be the i-th bit (counting from LSB) of coordinate j,
-	 * and let D' = D-1, and t = targetLevel-1. Then return
-	 *  X[t, D'] o X[t, D'-1] o ... o X[t, 0]   o  X[t-1, D'] o ... o X[t-1, 0]   o  ...  o  X[0, D'] o ... o X[0, 0]
-	 *
-	 * The following in a naive implementation of this bit interleaving:
-	 */
-	unsigned int result = 0u;
-	unsigned int bit = 0;
-	for(auto l = 0u; l != targetLevel; l++) {
-	    for(auto d = 0u; d != D; d++) {
-	        result |= ((coords[d] >> l) & 1) << bit++;
-	    }
-	}
-
-    return result + firstCellOfLevel(targetLevel);
-
-	// TODO: We can use shifts and masks to use word-parallelism
-	// TODO: We can use the AVX2 instruction pdep
-	// TODO: Write benchmark what's faster given that we consider at most targetLevel bits per coordinate
+    std::array<double, D> fixedPoint;
+    std::copy(point.begin(), point.end(), fixedPoint.begin());
+    return cellForPoint(fixedPoint, targetLevel);
+}
+
+template<unsigned int D>
+CellIndex SpatialTreeCoordinateHelper<D>::cellForPoint(const std::array<double, D>& point, unsigned int targetLevel) const {
+    // calculate coords
+    auto diameter = static_cast<double>(numCellsPerDimension(targetLevel));
+
+    std::array<CellIndex, D> coords;
+    for (auto d = 0u; d < D; ++d)
+        coords[d] = static_cast<CellIndex>(point[d] * diameter);
+
+    /*
+     * We now interleave the bits of the coordinates, let X[i,j] be the i-th bit (counting from LSB) of coordinate j,
+     * and let D' = D-1, and t = targetLevel-1. Then return
+     *  X[t, D'] o X[t, D'-1] o ... o X[t, 0]   o  X[t-1, D'] o ... o X[t-1, 0]   o  ...  o  X[0, D'] o ... o X[0, 0]
+     *
+     * The encoder is selected at compile time, see BitManipulation.h
+     */
+    return BitManipulation::Default<D, CellIndex>::deposit(coords) + firstCellOfLevel(targetLevel);
+}
+
+template<unsigned int D>
+template<typename PointAccess>
+void SpatialTreeCoordinateHelper<D>::cellsForPoints(std::size_t count, PointAccess point, unsigned int targetLevel, CellIndex* cells) const {
+    const auto diameter = static_cast<double>(numCellsPerDimension(targetLevel));
+    const auto firstCell = firstCellOfLevel(targetLevel);
+
+    // convert a block of points to integer coordinates first (vectorizable) and then encode the block
+    constexpr std::size_t blockSize = 64;
+    std::array<std::array<CellIndex, D>, blockSize> coords;
+    for (std::size_t begin = 0; begin < count; begin += blockSize) {
+        const auto size = std::min(blockSize, count - begin);
+        for (std::size_t i = 0; i < size; ++i) {
+            const auto& p = point(begin + i);
+            for (auto d = 0u; d < D; ++d)
+                coords[i][d] = static_cast<CellIndex>(p[d] * diameter);
+        }
+        for (std::size_t i = 0; i < size; ++i)
+            cells[begin + i] = BitManipulation::Default<D, CellIndex>::deposit(coords[i]) + firstCell;
+    }
 }
 
 template<unsigned int D>
-bool SpatialTreeCoordinateHelper<D>::touching(unsigned int cellA, unsigned int cellB, unsigned int level) const {
-    auto& coordA = m_coords[cellA];
-    auto& coordB = m_coords[cellB];
-    auto touching = true;
+bool SpatialTreeCoordinateHelper<D>::touching(CellIndex cellA, CellIndex cellB, unsigned int level) const {
+    return cellDistance(cellA, cellB, level) <= 1;
+}
+
+template<unsigned int D>
+typename SpatialTreeCoordinateHelper<D>::CellCoord SpatialTreeCoordinateHelper<D>::cellDistance(CellIndex cellA, CellIndex cellB, unsigned int level) const {
+    const auto coordA = cellCoords(cellA, level);
+    const auto coordB = cellCoords(cellB, level);
+    const auto cellsPerDimension = static_cast<CellCoord>(numCellsPerDimension(level));
+    auto result = CellCoord(0);
     for(auto d=0u; d<D; ++d){
         auto dist = std::abs(coordA[d] - coordB[d]);
-        dist = std::min(dist, (1<<level) - dist);
-        touching &= dist<=1;
+        dist = std::min(dist, cellsPerDimension - dist);
+        result = std::max(result, dist);
     }
-    return touching;
+    return result;
 }
 
 template<unsigned int D>
-double SpatialTreeCoordinateHelper<D>::dist(std::vector<double> &a, std::vector<double> &b) {
+double SpatialTreeCoordinateHelper<D>::dist(const std::vector<double> &a, const std::vector<double> &b) {
     assert(a.size() == b.size());
     assert(a.size() == D);
 
@@ -95,20 +118,28 @@ double SpatialTreeCoordinateHelper<D>::dist(std::vector<double> &a, std::vector<
 }
 
 template<unsigned int D>
-double SpatialTreeCoordinateHelper<D>::dist(unsigned int cellA, unsigned int cellB, unsigned int level) const {
+double SpatialTreeCoordinateHelper<D>::dist(const std::array<double, D> &a, const std::array<double, D> &b) {
+    // max over the torus distance in all dimensions
+    return distUpTo(a, b, std::integral_constant<unsigned int, D>());
+}
+
+template<unsigned int D>
+template<unsigned int K>
+double SpatialTreeCoordinateHelper<D>::distUpTo(const std::array<double, D>& a, const std::array<double, D>& b, std::integral_constant<unsigned int, K>) {
+    auto dist = std::abs(a[K-1] - b[K-1]);
+    dist = dist < 1.0 - dist ? dist : 1.0 - dist;
+    const auto result = distUpTo(a, b, std::integral_constant<unsigned int, K-1>());
+    return result > dist ? result : dist;
+}
+
+template<unsigned int D>
+double SpatialTreeCoordinateHelper<D>::dist(CellIndex cellA, CellIndex cellB, unsigned int level) const {
 
     // first work with integer d dimensional index
-    auto& coordA = m_coords[cellA];
-    auto& coordB = m_coords[cellB];
-    auto result = 0;
-    for(auto d=0u; d<D; ++d){
-        auto dist = std::abs(coordA[d] - coordB[d]);
-        dist = std::min(dist, (1<<level) - dist);
-        result = std::max(result, dist);
-    }
+    const auto result = cellDistance(cellA, cellB, level);
 
     // then apply the diameter
-    auto diameter = 1.0 / (1<<level);
+    auto diameter = 1.0 / numCellsPerDimension(level);
     return std::max(0.0, (result-1) * diameter); // TODO if cellA and cellB are not touching, this max is irrelevant
 }
 
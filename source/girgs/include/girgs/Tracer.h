@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <omp.h>
+
+#include <girgs/girgs_api.h>
+#include <girgs/IndexTypes.h>
+
+
+namespace girgs {
+
+
+/**
+ * @brief
+ *  Records spans of the edge sampling per thread and writes them as Chrome trace events
+ *  (JSON that can be opened in chrome://tracing or https://ui.perfetto.dev).
+ *
+ *  SpatialTree only records spans if the library is built with OPTION_TRACING (which defines GIRGS_TRACING).
+ *  Otherwise all tracing code is removed by the preprocessor, so there is no cost in production builds.
+ *  The spans of all generations are collected in the global tracer until clear() is called.
+ */
+class GIRGS_API Tracer
+{
+public:
+    /// a finished span
+    struct Event {
+        const char*   name;     ///< static string naming the kind of span
+        double        begin;    ///< start in microseconds since the creation of the tracer
+        double        duration; ///< in microseconds
+        unsigned int  level;    ///< level of the traced cell
+        CellIndex     cell;     ///< the traced cell, i.e. cellA of the visited cell pairs
+        std::int64_t  points;   ///< points that are in the traced cell
+        std::uint64_t edges;    ///< edges produced in the span
+    };
+
+    /// @return the tracer used by SpatialTree, it is shared by all users of the library
+    static Tracer& global();
+
+    /// whether SpatialTree records spans, i.e. the library is built with GIRGS_TRACING
+    static constexpr bool enabled() {
+#ifdef GIRGS_TRACING
+        return true;
+#else
+        return false;
+#endif // GIRGS_TRACING
+    }
+
+    /**
+     * @brief
+     *  Besides the cell buckets or tasks of the parallel phase, the visits of cells are traced for all levels up to maxLevel.
+     *  Deep levels produce huge traces. The default -1 traces the buckets only.
+     */
+    void setMaxLevel(int maxLevel) { m_maxLevel = maxLevel; }
+
+    /// @return whether visits of cell pairs in level are traced (see setMaxLevel(int))
+    bool tracesLevel(unsigned int level) const { return static_cast<int>(level) <= m_maxLevel; }
+
+    /// makes sure that threads [0, numThreads) have their slots, must not be called concurrently to other methods
+    void prepare(int numThreads) {
+        if (static_cast<int>(m_threads.size()) < numThreads)
+            m_threads.resize(numThreads);
+    }
+
+    /// removes all events
+    void clear() {
+        for (auto& each : m_threads)
+            each.events.clear();
+    }
+
+    /// @return the current time in microseconds since the creation of the tracer
+    double now() const { return (omp_get_wtime() - m_epoch) * 1e6; }
+
+    /// counts an edge produced by thread
+    void countEdge(int thread) { ++m_threads[thread].edges; }
+
+    /// @return the number of edges counted for thread so far
+    std::uint64_t edges(int thread) const { return m_threads[thread].edges; }
+
+    /// stores a finished span of thread
+    void record(int thread, const Event& event) { m_threads[thread].events.push_back(event); }
+
+    /// @return all recorded spans of thread
+    const std::vector<Event>& events(int thread) const { return m_threads[thread].events; }
+
+    /// @return the number of threads with slots (see prepare(int))
+    int threads() const { return static_cast<int>(m_threads.size()); }
+
+    /**
+     * @brief
+     *  Writes all spans as Chrome trace events of the JSON object format.
+     *
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void write(const std::string& file) const;
+
+protected:
+    Tracer();
+
+    /// events and edge counter of one thread, padded to keep the counters of different threads apart
+    struct ThreadSlot {
+        std::vector<Event> events;
+        std::uint64_t edges = 0;
+        char padding[64];
+    };
+
+    double m_epoch;                     ///< omp_get_wtime() at creation
+    int m_maxLevel;                     ///< deepest level in which visits are traced
+    std::vector<ThreadSlot> m_threads;  ///< one slot per thread
+};
+
+
+/**
+ * @brief
+ *  Records a span of the calling thread from its construction to its destruction in the global Tracer,
+ *  including the number of edges the thread produced in between.
+ */
+class TraceSpan
+{
+public:
+    /**
+     * @param name
+     *  Static string naming the kind of span.
+     * @param level, cell, points
+     *  The traced cell, its level and the number of points in it.
+     * @param active
+     *  If false, nothing is recorded.
+     */
+    TraceSpan(const char* name, unsigned int level, CellIndex cell, std::int64_t points, bool active = true)
+        : m_active(active), m_thread(omp_get_thread_num())
+    {
+        if (!m_active)
+            return;
+        auto& tracer = Tracer::global();
+        m_event = Tracer::Event{name, tracer.now(), 0.0, level, cell, points, tracer.edges(m_thread)};
+    }
+
+    ~TraceSpan() {
+        if (!m_active)
+            return;
+        auto& tracer = Tracer::global();
+        m_event.duration = tracer.now() - m_event.begin;
+        m_event.edges = tracer.edges(m_thread) - m_event.edges;
+        tracer.record(m_thread, m_event);
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+protected:
+    bool m_active;          ///< whether the span is recorded
+    int m_thread;           ///< the thread that owns the span
+    Tracer::Event m_event;  ///< the event, edges holds the count at construction until destruction
+};
+
+
+} // namespace girgs
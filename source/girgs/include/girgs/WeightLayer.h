@@ -1,9 +1,10 @@
-
 #pragma once
 
 #include <vector>
+#include <array>
 #include <cmath>
 
+#include <girgs/IndexTypes.h>
 #include <girgs/Node.h>
 #include <girgs/SpatialTreeCoordinateHelper.h>
 
@@ -16,6 +17,9 @@ namespace girgs {
  *  This class implements the data structure to manage point access described in the paper (Lemma 4.1).
  *  The partitioning of the ground space (Lemma 4.2) implicitly results from the implementation of SpatialTree.
  *
+ *  Positions, weights, and indices of all points in the layer are copied into contiguous arrays sorted by the cell in target level.
+ *  Thus the points of one cell (in any level up to target level) form a consecutive range in all arrays.
+ *
  * @tparam D
  *  the dimension of the geometry
  */
@@ -24,7 +28,24 @@ class WeightLayer {
 public:
 
     WeightLayer() = delete;
-    WeightLayer(unsigned int layer, unsigned int targetLevel, const SpatialTreeCoordinateHelper<D>& helper, std::vector<Node*>&& nodes);
+
+    /**
+     * @brief
+     *  Sorts the given nodes into the cells of the target level.
+     *
+     * @param layer
+     *  The index of the layer.
+     * @param targetLevel
+     *  The insertion level for all nodes of this layer.
+     * @param helper
+     *  A coordinate helper with at least targetLevel+1 levels.
+     * @param nodes
+     *  The indices of all nodes in this layer.
+     * @param graph
+     *  The graph that provides positions and weights of the nodes.
+     */
+    WeightLayer(unsigned int layer, unsigned int targetLevel, const SpatialTreeCoordinateHelper<D>& helper,
+                const std::vector<NodeIndex>& nodes, const std::vector<Node>& graph);
 
 
     /**
@@ -39,41 +60,40 @@ public:
      * @return
      *  Returns how many points there are in cells {begin..end} using prefix sums. Begin and end are the first/last descendants of cell in target level.
      */
-    int pointsInCell(unsigned int cell, unsigned int level) const;
+    NodeIndex pointsInCell(CellIndex cell, unsigned int level) const;
 
 
     /**
      * @brief
      *  Implements the second operation required for the data structure in the paper (Lemma 4.1).
      *  The method finds the first descendant of the given cell in the target level.
-     *  Then #m_prefix_sums and #m_A are used to find the requested point.
+     *  Then #m_prefix_sums is used to find the position of the first point of the cell in the point arrays.
+     *  The k-th point in the cell is thus stored at offset firstPointInCell(cell, level) + k.
      *
      * @param cell
      *  The cell that contains the points.
      * @param level
      *  The level of the given cell.
      *  This should be less or equal to the target level of this weight layer.
-     * @param k
-     *  The point we want to access.
-     *  This should be less than the number of points of this weight layer in the given cell
-     *  (i.e. less than what was returned by pointsInCell(unsigned int, unsigned int) const ).
      * @return
-     *  Returns a pointer to the requested node.
+     *  Returns the offset of the first point of the cell in positions(), weights(), and indices().
      */
-    Node* kthPoint(unsigned int cell, unsigned int level, int k) const;
+    NodeIndex firstPointInCell(CellIndex cell, unsigned int level) const;
 
-	Node* const * firstPointPointer(unsigned int cell, unsigned int level) const;
+    const std::vector<std::array<double, D>>& positions() const { return m_positions; }
+    const std::vector<double>& weights() const { return m_weights; }
+    const std::vector<NodeIndex>& indices() const { return m_indices; }
 
 protected:
 
     const unsigned int m_layer;             ///< the index of the layer
     const unsigned int m_target_level;      ///< the insertion level for the current weight layer (v(i) = wiw0/W)
 
-    std::vector<Node*> m_nodes;             ///< all nodes of the current weight layer
+    std::vector<NodeIndex> m_prefix_sums;   ///< for each cell c in target level: the sum of points of this layer in all cells <c
 
-    std::vector<int>   m_points_in_cell;    ///< the number of points in each cell of target_level
-    std::vector<int>   m_prefix_sums;       ///< for each cell c in target level: the sum of points of this layer in all cells <c
-    std::vector<Node*> m_A;                 ///< m_A[m_prefix_sums[i]+k] contains the k-th point in the i-th cell of target level
+    std::vector<std::array<double, D>> m_positions; ///< positions of all points of the layer sorted by cell in target level
+    std::vector<double> m_weights;          ///< weights of all points of the layer in the same order as #m_positions
+    std::vector<NodeIndex> m_indices;       ///< node indices of all points of the layer in the same order as #m_positions
 };
 
 
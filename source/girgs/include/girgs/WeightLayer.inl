@@ -6,10 +6,10 @@ template<unsigned int D>
 WeightLayer<D>::WeightLayer(unsigned int layer,
                             unsigned int targetLevel,
                             const SpatialTreeCoordinateHelper<D>& helper,
-                            std::vector<Node*>&& nodes)
+                            const std::vector<NodeIndex>& nodes,
+                            const std::vector<Node>& graph)
     : m_layer(layer)
     , m_target_level(targetLevel) // w0*wi/W = 2^(-dl) solved for l --- l = (log2(W/w0^2) - i) / d
-    , m_nodes(std::move(nodes))
 {
 
     // convenience constants
@@ -18,39 +18,50 @@ WeightLayer<D>::WeightLayer(unsigned int layer,
     const auto lastCell = firstCell + cellsInLevel - 1;
 
     // allocate stuff
-    m_points_in_cell.resize(cellsInLevel, 0);
-    m_prefix_sums.resize(cellsInLevel, 0);
-    m_A.resize(m_nodes.size(), nullptr);
+    m_prefix_sums.resize(cellsInLevel+1, 0);
+    m_positions.resize(nodes.size());
+    m_weights.resize(nodes.size());
+    m_indices.resize(nodes.size());
 
     // count num of points in each cell
-	auto cellForPoint = std::vector<unsigned int>(m_nodes.size(), -1);
-	for (int i = 0; i < m_nodes.size(); ++i) {
-        auto targetCell = helper.cellForPoint(m_nodes[i]->coord, m_target_level);
-		cellForPoint[i] = targetCell; // remeber this for last loop
+	auto cellForPoint = std::vector<CellIndex>(nodes.size(), -1);
+    auto coordOfNode = [&graph, &nodes](std::size_t i) -> const std::vector<double>& { return graph[nodes[i]].coord; };
+    helper.cellsForPoints(nodes.size(), coordOfNode, m_target_level, cellForPoint.data()); // remeber this for last loop
+	for (std::size_t i = 0; i < nodes.size(); ++i) {
+        auto targetCell = cellForPoint[i];
         assert(firstCell <= targetCell && targetCell <= lastCell); // cell on right level
-        ++m_points_in_cell[targetCell - firstCell];
+        ++m_prefix_sums[targetCell - firstCell];
     }
 
-    // fill prefix sums
+    // compute exclusive prefix sums
     // prefix_sums[i] is the number of all points in cells j<i of the same level
-    m_prefix_sums[0] = 0;
-    for(auto cell = 1u; cell < cellsInLevel; ++cell) {
-        m_prefix_sums[cell] = m_prefix_sums[cell-1] + m_points_in_cell[cell-1];
+    {
+        NodeIndex sum = 0;
+        for(auto& val : m_prefix_sums) {
+            const auto tmp = val;
+            val = sum;
+            sum += tmp;
+        }
     }
 
-    // fill point lookup
-    auto num_inserted = std::vector<int>(cellsInLevel, 0); // keeps track of bucket size for counting sort
-    for(int i = 0; i < m_nodes.size(); ++i){
+    // fill point arrays in cell order
+    auto num_inserted = std::vector<NodeIndex>(cellsInLevel, 0); // keeps track of bucket size for counting sort
+    for(std::size_t i = 0; i < nodes.size(); ++i){
         auto targetCell = cellForPoint[i];
         assert(firstCell <= targetCell && targetCell <= lastCell); // cell on right level
-        m_A[m_prefix_sums[targetCell-firstCell] + num_inserted[targetCell-firstCell]] = m_nodes[i];
+        auto& node = graph[nodes[i]];
+        auto pos = m_prefix_sums[targetCell-firstCell] + num_inserted[targetCell-firstCell];
+        for(auto d=0u; d<D; ++d)
+            m_positions[pos][d] = node.coord[d];
+        m_weights[pos] = node.weight;
+        m_indices[pos] = nodes[i];
         ++num_inserted[targetCell-firstCell];
     }
 }
 
 
 template<unsigned int D>
-int WeightLayer<D>::pointsInCell(unsigned int cell, unsigned int level) const {
+NodeIndex WeightLayer<D>::pointsInCell(CellIndex cell, unsigned int level) const {
     using Helper = SpatialTreeCoordinateHelper<D>;
     assert(level <= m_target_level);
     assert(Helper::firstCellOfLevel(level) <= cell && cell < Helper::firstCellOfLevel(level+1)); // cell is from correct level
@@ -66,12 +77,12 @@ int WeightLayer<D>::pointsInCell(unsigned int cell, unsigned int level) const {
     assert(begin + Helper::firstCellOfLevel(level) < Helper::firstCellOfLevel(m_target_level+1));
     assert(end + Helper::firstCellOfLevel(level) < Helper::firstCellOfLevel(m_target_level+1));
 
-    return m_prefix_sums[end] - m_prefix_sums[begin] + m_points_in_cell[end];
+    return m_prefix_sums[end+1] - m_prefix_sums[begin];
 }
 
 
 template<unsigned int D>
-Node* WeightLayer<D>::kthPoint(unsigned int cell, unsigned int level, int k) const {
+NodeIndex WeightLayer<D>::firstPointInCell(CellIndex cell, unsigned int level) const {
     using Helper = SpatialTreeCoordinateHelper<D>;
     assert(level <= m_target_level);
     assert(Helper::firstCellOfLevel(level) <= cell && cell < Helper::firstCellOfLevel(level+1)); // cell is from fromLevel
@@ -82,24 +93,7 @@ Node* WeightLayer<D>::kthPoint(unsigned int cell, unsigned int level, int k) con
     auto localIndexDescendant = localIndexCell * descendants;
     auto begin = localIndexDescendant;
 
-    return m_A[m_prefix_sums[begin] + k];
-}
-
-
-template<unsigned int D>
-Node* const * WeightLayer<D>::firstPointPointer(unsigned int cell, unsigned int level) const
-{
-	using Helper = SpatialTreeCoordinateHelper<D>;
-	assert(level <= m_target_level);
-	assert(Helper::firstCellOfLevel(level) <= cell && cell < Helper::firstCellOfLevel(level + 1)); // cell is from fromLevel
-
-	// same as in "pointsInCell"
-	auto descendants = Helper::numCellsInLevel(m_target_level - level);
-	auto localIndexCell = cell - Helper::firstCellOfLevel(level);
-	auto localIndexDescendant = localIndexCell * descendants;
-	auto begin = localIndexDescendant;
-
-	return m_A.data() + m_prefix_sums[begin];
+    return m_prefix_sums[begin];
 }
 
 
@@ -0,0 +1,125 @@
+#include <girgs/BinaryEdgeList.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+
+namespace girgs {
+
+
+namespace {
+
+const char c_magic[8] = {'G', 'I', 'R', 'G', 'E', 'D', 'G', 'E'};
+const std::uint32_t c_version = 1;
+
+} // namespace
+
+
+BinaryEdgeListWriter::BinaryEdgeListWriter(const std::string& file, std::uint64_t numNodes, std::uint64_t numEdges, unsigned int indexBytes)
+: m_file(file)
+, m_indexBytes(indexBytes)
+, m_size(sizeof(BinaryEdgeListHeader) + 2 * numEdges * indexBytes)
+, m_data(nullptr)
+, m_fd(-1)
+{
+    assert(indexBytes == 4 || indexBytes == 8);
+    assert(indexBytes == 8 || numNodes <= (std::uint64_t(1) << 32));
+
+#ifndef _WIN32
+    m_fd = open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_fd < 0)
+        throw std::runtime_error("cannot create " + file);
+    if (ftruncate(m_fd, static_cast<off_t>(m_size)) != 0) {
+        close(m_fd);
+        throw std::runtime_error("cannot resize " + file);
+    }
+    auto mapping = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (mapping == MAP_FAILED) {
+        close(m_fd);
+        throw std::runtime_error("cannot map " + file);
+    }
+    m_data = static_cast<char*>(mapping);
+#else
+    m_buffer.resize(m_size);
+    m_data = m_buffer.data();
+#endif // _WIN32
+
+    auto header = BinaryEdgeListHeader();
+    std::memcpy(header.magic, c_magic, sizeof(c_magic));
+    header.numNodes = numNodes;
+    header.numEdges = numEdges;
+    header.indexBytes = indexBytes;
+    header.version = c_version;
+    std::memcpy(m_data, &header, sizeof(header));
+}
+
+BinaryEdgeListWriter::~BinaryEdgeListWriter() {
+#ifndef _WIN32
+    munmap(m_data, m_size);
+    close(m_fd);
+#else
+    std::ofstream(m_file, std::ios::binary).write(m_data, m_size);
+#endif // _WIN32
+}
+
+
+BinaryEdgeList::BinaryEdgeList(const std::string& file)
+: m_size(0)
+, m_data(nullptr)
+{
+#ifndef _WIN32
+    auto fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("cannot open " + file);
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(BinaryEdgeListHeader)) {
+        close(fd);
+        throw std::runtime_error(file + " is not a binary edge list");
+    }
+    m_size = static_cast<std::size_t>(info.st_size);
+    auto mapping = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (mapping == MAP_FAILED)
+        throw std::runtime_error("cannot map " + file);
+    m_data = static_cast<const char*>(mapping);
+#else
+    auto f = std::ifstream(file, std::ios::binary | std::ios::ate);
+    if (!f)
+        throw std::runtime_error("cannot open " + file);
+    m_size = static_cast<std::size_t>(f.tellg());
+    m_buffer.resize(std::max(m_size, sizeof(BinaryEdgeListHeader)));
+    f.seekg(0);
+    f.read(m_buffer.data(), m_size);
+    m_data = m_buffer.data();
+#endif // _WIN32
+
+    const auto valid = m_size >= sizeof(BinaryEdgeListHeader)
+        && std::memcmp(header().magic, c_magic, sizeof(c_magic)) == 0
+        && header().version == c_version
+        && (indexBytes() == 4 || indexBytes() == 8)
+        && m_size == sizeof(BinaryEdgeListHeader) + 2 * numEdges() * indexBytes();
+    if (!valid) {
+#ifndef _WIN32
+        munmap(const_cast<char*>(m_data), m_size);
+#endif // _WIN32
+        throw std::runtime_error(file + " is not a binary edge list");
+    }
+}
+
+BinaryEdgeList::~BinaryEdgeList() {
+#ifndef _WIN32
+    munmap(const_cast<char*>(m_data), m_size);
+#endif // _WIN32
+}
+
+
+} // namespace girgs
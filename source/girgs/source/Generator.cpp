@@ -1,17 +1,162 @@
 
 #include <girgs/Generator.h>
-
+#include <girgs/BinaryEdgeList.h>
+#include <girgs/CounterBasedEngine.h>
+#include <girgs/PrefixSum.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <limits>
 #include <random>
+#include <type_traits>
 
-#include <girgs/SpatialTree.h>
+#include <omp.h>
 
 
 using namespace girgs;
 
 
+namespace {
+
+// Sampling of weights and positions is split into blocks of this many nodes.
+// Block b draws its random numbers from a CounterBasedEngine keyed by the seed and b,
+// so the result does not depend on the number of threads.
+constexpr NodeIndex c_samplingBlockSize = 1 << 13;
+
+// writes the edges of node u to pairs[2*offsets[u]], ... in parallel
+template<typename IndexType>
+void writeEdgeSlices(const std::vector<Node>& graph, const std::vector<std::uint64_t>& offsets, IndexType* pairs) {
+    const auto n = static_cast<long long>(graph.size());
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (long long u = 0; u < n; ++u) {
+        auto out = pairs + 2*offsets[u];
+        for (auto to : graph[u].edges) {
+            *out++ = static_cast<IndexType>(graph[u].index);
+            *out++ = static_cast<IndexType>(to->index);
+        }
+    }
+}
+
+// maximal number of characters of a non negative node index in decimal
+constexpr std::size_t c_maxIntChars = std::numeric_limits<NodeIndex>::digits10 + 1;
+
+// writes the decimal representation of a non negative node index to out and returns the position after the last digit
+char* writeInt(char* out, NodeIndex value) {
+    static const char digit_pairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    assert(value >= 0);
+
+    // write the digits back to front into a temporary and copy them
+    char digits[c_maxIntChars];
+    auto pos = c_maxIntChars;
+    auto rest = static_cast<std::make_unsigned<NodeIndex>::type>(value);
+    while (rest >= 100) {
+        const auto pair = (rest % 100) * 2;
+        rest /= 100;
+        digits[--pos] = digit_pairs[pair + 1];
+        digits[--pos] = digit_pairs[pair];
+    }
+    if (rest >= 10) {
+        digits[--pos] = digit_pairs[rest * 2 + 1];
+        digits[--pos] = digit_pairs[rest * 2];
+    } else {
+        digits[--pos] = static_cast<char>('0' + rest);
+    }
+
+    const auto length = c_maxIntChars - pos;
+    std::memcpy(out, digits + pos, length);
+    return out + length;
+}
+
+// Sums count terms in fixed blocks of c_summationBlockSize and adds the block results in order,
+// so the result does not depend on the number of threads. addTerm(acc, i) adds the i-th terms to acc.
+constexpr long long c_summationBlockSize = 1 << 12;
+
+template<std::size_t K, typename AddTerm>
+std::array<double, K> blockedSums(long long count, AddTerm addTerm) {
+    const auto blocks = (count + c_summationBlockSize - 1) / c_summationBlockSize;
+    auto partial = std::vector<std::array<double, K>>(blocks);
+
+    #pragma omp parallel for schedule(dynamic) if(blocks > 1)
+    for (long long block = 0; block < blocks; ++block) {
+        auto acc = std::array<double, K>();
+        acc.fill(0.0);
+        const auto end = std::min(count, (block + 1) * c_summationBlockSize);
+        for (auto i = block * c_summationBlockSize; i < end; ++i)
+            addTerm(acc, i);
+        partial[block] = acc;
+    }
+
+    auto result = std::array<double, K>();
+    result.fill(0.0);
+    for (auto& acc : partial)
+        for (std::size_t k = 0; k < K; ++k)
+            result[k] += acc[k];
+    return result;
+}
+
+// Weights that are sorted descendingly on demand.
+// The first m_sorted weights are sorted and all others are at most m_bound, so the weights above
+// a threshold form a prefix that only grows when the threshold drops below all previous ones.
+// Prefix sums of the weights (and of the weights to the power of alpha if alpha != 0) over the
+// sorted prefix are kept alongside, such that the state can be reused across many thresholds.
+class DescendingWeights {
+public:
+    DescendingWeights(std::vector<double> weights, double alpha)
+        : m_weights(std::move(weights)), m_alpha(alpha), m_sorted(0)
+        , m_bound(std::numeric_limits<double>::infinity())
+        , m_prefix(1, 0.0), m_prefix_a(1, 0.0) {}
+
+    // sorts all weights greater than threshold to the front and returns their number
+    std::size_t sortGreater(double threshold) {
+        if (threshold < m_bound) {
+            auto begin = m_weights.begin() + m_sorted;
+            auto end = std::partition(begin, m_weights.end(), [threshold](double w) { return w > threshold; });
+            std::sort(begin, end, std::greater<double>());
+
+            for (auto it = begin; it != end; ++it) {
+                m_prefix.push_back(m_prefix.back() + *it);
+                if (m_alpha != 0.0)
+                    m_prefix_a.push_back(m_prefix_a.back() + std::pow(*it, m_alpha));
+            }
+            m_sorted = static_cast<std::size_t>(end - m_weights.begin());
+            m_bound = threshold;
+        }
+        return countGreater(threshold);
+    }
+
+    // number of weights greater than threshold, requires a previous sortGreater with a threshold at most this one
+    std::size_t countGreater(double threshold) const {
+        assert(threshold >= m_bound);
+        auto end = m_weights.begin() + m_sorted;
+        return static_cast<std::size_t>(std::lower_bound(m_weights.begin(), end, threshold, std::greater<double>()) - m_weights.begin());
+    }
+
+    double weight(std::size_t i) const { return m_weights[i]; }
+
+    // sum of the i largest weights (to the power of alpha)
+    double prefixSum(std::size_t i) const { return m_prefix[i]; }
+    double prefixPowSum(std::size_t i) const { return m_prefix_a[i]; }
+
+private:
+    std::vector<double> m_weights;
+    double m_alpha;
+    std::size_t m_sorted;
+    double m_bound;
+    std::vector<double> m_prefix;
+    std::vector<double> m_prefix_a;
+};
+
+} // namespace
+
+
 void Generator::setWeights(const std::vector<double>& weights) {
     auto n = weights.size();
     assert(m_graph.empty() || m_graph.size() == n);
@@ -21,15 +166,24 @@ void Generator::setWeights(const std::vector<double>& weights) {
 }
 
 
-void Generator::setWeights(int n, double ple, int weightSeed) {
-    assert(m_graph.empty() || m_graph.size() == n);
+void Generator::setWeights(NodeIndex n, double ple, int weightSeed) {
+    assert(m_graph.empty() || static_cast<NodeIndex>(m_graph.size()) == n);
     assert(ple <= -2);
     if(m_graph.empty()) m_graph.resize(n);
 
-    auto gen = std::mt19937(weightSeed >= 0 ?  weightSeed : std::random_device()());
-    std::uniform_real_distribution<> dist; // [0..1)
-    for(int i=0; i<n; ++i)
-        m_graph[i].weight = std::pow((std::pow(n,ple+1)-1)*dist(gen) + 1, 1/(ple+1));
+    const auto seed = weightSeed >= 0 ? weightSeed : std::random_device()();
+    const auto factor = std::pow(n, ple+1) - 1;
+    const auto exponent = 1 / (ple+1);
+    const auto num_blocks = (n + c_samplingBlockSize - 1) / c_samplingBlockSize;
+
+    #pragma omp parallel for schedule(static)
+    for(NodeIndex block=0; block<num_blocks; ++block) {
+        auto gen = CounterBasedEngine(seed, block);
+        std::uniform_real_distribution<> dist; // [0..1)
+        const auto end = std::min(n, (block+1) * c_samplingBlockSize);
+        for(auto i=block*c_samplingBlockSize; i<end; ++i)
+            m_graph[i].weight = std::pow(factor*dist(gen) + 1, exponent);
+    }
 }
 
 
@@ -37,50 +191,63 @@ void Generator::setPositions(const std::vector<std::vector<double>>& positions)
     auto n = positions.size();
     assert(m_graph.empty() || m_graph.size() == n);
     if(m_graph.empty()) m_graph.resize(n);
-    for(int i=0; i<n; ++i) {
+    for(std::size_t i=0; i<n; ++i) {
         assert(positions[i].size() == positions.front().size()); // all same dimension
         m_graph[i].coord = positions[i];
     }
 }
 
 
-void Generator::setPositions(int n, int dimension, int positionSeed) {
-    assert(m_graph.empty() || m_graph.size() == n);
+void Generator::setPositions(NodeIndex n, int dimension, int positionSeed) {
+    assert(m_graph.empty() || static_cast<NodeIndex>(m_graph.size()) == n);
     if(m_graph.empty()) m_graph.resize(n);
 
-    auto gen = std::mt19937(positionSeed >= 0 ?  positionSeed : std::random_device()());
-    std::uniform_real_distribution<> dist; // [0..1)
-
-    for(int i=0; i<n; ++i) {
-        m_graph[i].coord.resize(dimension);
-        for (int d=0; d<dimension; ++d)
-            m_graph[i].coord[d] = dist(gen);
+    const auto seed = positionSeed >= 0 ? positionSeed : std::random_device()();
+    const auto num_blocks = (n + c_samplingBlockSize - 1) / c_samplingBlockSize;
+
+    // the coordinates of a block are contiguous in the random stream of the block
+    #pragma omp parallel for schedule(static)
+    for(NodeIndex block=0; block<num_blocks; ++block) {
+        auto gen = CounterBasedEngine(seed, block);
+        std::uniform_real_distribution<> dist; // [0..1)
+        const auto end = std::min(n, (block+1) * c_samplingBlockSize);
+        for(auto i=block*c_samplingBlockSize; i<end; ++i) {
+            m_graph[i].coord.resize(dimension);
+            for (int d=0; d<dimension; ++d)
+                m_graph[i].coord[d] = dist(gen);
+        }
     }
 }
 
 
+void Generator::setShard(int shard, int numShards) {
+    assert(0 <= shard && shard < numShards);
+    m_shard = shard;
+    m_numShards = numShards;
+}
+
+
 double Generator::scaleWeights(double desiredAvgDegree, int dimension, double alpha) {
     assert(!m_graph.empty());
     auto n = m_graph.size();
 
     { // TODO change the whole block
         // shamefully copy all weights
-        auto currentWeights = std::vector<double>(n);
-        for(int i=0; i<n; ++i)
-            currentWeights[i] = m_graph[i].weight;
+        auto currentWeights = weights();
 
         // estimate scaling with binary search
         double scaling;
         if(alpha > 10.0)
-            scaling = estimateWeightScalingThreshold(currentWeights, desiredAvgDegree, dimension);
+            scaling = estimateWeightScalingThreshold(std::move(currentWeights), desiredAvgDegree, dimension);
         else if(alpha > 0.0 && alpha != 1.0)
-            scaling = estimateWeightScaling(currentWeights, desiredAvgDegree, dimension, alpha);
+            scaling = estimateWeightScaling(std::move(currentWeights), desiredAvgDegree, dimension, alpha);
         else
             throw("I do not know how to scale weights for desired alpha :(");
 
         // scale weights
-        for(auto& each : m_graph)
-            each.weight *= scaling;
+        #pragma omp parallel for schedule(static)
+        for(long long i=0; i<static_cast<long long>(n); ++i)
+            m_graph[i].weight *= scaling;
         return scaling;
     }
 }
@@ -90,24 +257,15 @@ double Generator::scaleWeights(double desiredAvgDegree, int dimension, double al
 
 void Generator::generate(double alpha, int samplingSeed) {
     assert(!m_graph.empty());
-    for(auto& each : m_graph) each.edges.clear();
-    auto dimension = m_graph.front().coord.size();
-    switch(dimension) {
-        case 1: SpatialTree<1>().generateEdges(m_graph, alpha, samplingSeed); break;
-        case 2: SpatialTree<2>().generateEdges(m_graph, alpha, samplingSeed); break;
-        case 3: SpatialTree<3>().generateEdges(m_graph, alpha, samplingSeed); break;
-        case 4: SpatialTree<4>().generateEdges(m_graph, alpha, samplingSeed); break;
-        case 5: SpatialTree<5>().generateEdges(m_graph, alpha, samplingSeed); break;
-        default:
-            std::cout << "Dimension " << dimension << " not supported." << std::endl;
-            std::cout << "No edges generated." << std::endl;
-            break;
-    }
+    auto addEdge = [this](NodeIndex u, NodeIndex v, int) {
+        m_graph[u].edges.push_back(&m_graph[v]);
+    };
+    generate(alpha, samplingSeed, addEdge);
 }
 
 
 std::vector<Node> Generator::generate(
-        int n, int dimension, double ple, double alpha, double desiredAvgDegree, int weightSeed, int positionSeed, int samplingSeed) {
+        NodeIndex n, int dimension, double ple, double alpha, double desiredAvgDegree, int weightSeed, int positionSeed, int samplingSeed) {
 
     setWeights(n, ple, weightSeed);
     setPositions(n,dimension, positionSeed);
@@ -129,8 +287,8 @@ double Generator::avg_degree() const {
     return 2.0 * edges() / m_graph.size();
 }
 
-unsigned int girgs::Generator::edges() const {
-    auto edges = 0u;
+std::uint64_t girgs::Generator::edges() const {
+    auto edges = std::uint64_t(0);
     for (auto& each : graph())
         edges += each.edges.size();
     return edges;
@@ -165,60 +323,115 @@ void Generator::saveDot(std::string file) const {
 void girgs::Generator::saveEdgeList(std::string file) const {
     auto f = std::ofstream(file);
     f << m_graph.size() << ' ' << edges() << '\n';
-    for (auto& from : m_graph)
-        for (auto to : from.edges)
-            f << from.index << ' ' << to->index << '\n';
+
+    // Nodes are split into blocks that are formatted in parallel, each into its own buffer.
+    // We process the blocks in rounds to bound the memory and write the buffers of a round in order.
+    const auto n = static_cast<long long>(m_graph.size());
+    const auto block_size = 1ll << 14;
+    const auto num_blocks = (n + block_size - 1) / block_size;
+    const auto blocks_per_round = 4ll * omp_get_max_threads();
+    auto buffers = std::vector<std::vector<char>>(blocks_per_round);
+    auto lengths = std::vector<std::size_t>(blocks_per_round);
+
+    for (auto first_block = 0ll; first_block < num_blocks; first_block += blocks_per_round) {
+        const auto round_blocks = std::min(blocks_per_round, num_blocks - first_block);
+
+        #pragma omp parallel for schedule(dynamic)
+        for (long long b = 0; b < round_blocks; ++b) {
+            const auto begin = (first_block + b) * block_size;
+            const auto end = std::min(begin + block_size, n);
+
+            // each line has two indices, a space, and a newline
+            auto max_length = std::size_t(0);
+            for (auto u = begin; u < end; ++u)
+                max_length += m_graph[u].edges.size() * (2 * c_maxIntChars + 2);
+            if (buffers[b].size() < max_length)
+                buffers[b].resize(max_length);
+
+            auto out = buffers[b].data();
+            for (auto u = begin; u < end; ++u) {
+                for (auto to : m_graph[u].edges) {
+                    out = writeInt(out, m_graph[u].index);
+                    *out++ = ' ';
+                    out = writeInt(out, to->index);
+                    *out++ = '\n';
+                }
+            }
+            lengths[b] = static_cast<std::size_t>(out - buffers[b].data());
+        }
+
+        for (auto b = 0ll; b < round_blocks; ++b)
+            f.write(buffers[b].data(), lengths[b]);
+    }
+}
+
+void girgs::Generator::saveBinaryEdgeList(std::string file) const {
+    const auto n = static_cast<long long>(m_graph.size());
+
+    // count edges per node to get the slice of each node in the file
+    auto offsets = std::vector<std::uint64_t>(n + 1, 0);
+    #pragma omp parallel for schedule(static)
+    for (long long u = 0; u < n; ++u)
+        offsets[u] = m_graph[u].edges.size();
+    const auto m = exclusivePrefixSum(offsets);
+
+    // each node writes its slice concurrently
+    BinaryEdgeListWriter writer(file, n, m, BinaryEdgeListWriter::indexBytesFor(n));
+    if (BinaryEdgeListWriter::indexBytesFor(n) == 4)
+        writeEdgeSlices(m_graph, offsets, writer.edges<std::uint32_t>());
+    else
+        writeEdgeSlices(m_graph, offsets, writer.edges<std::uint64_t>());
 }
 
 
 
 std::vector<double> Generator::weights() const {
     auto result = std::vector<double>(m_graph.size());
-    for(int i=0; i<m_graph.size(); ++i)
+    #pragma omp parallel for schedule(static)
+    for(long long i=0; i<static_cast<long long>(m_graph.size()); ++i)
         result[i] = m_graph[i].weight;
     return result;
 }
 
 std::vector<std::vector<double>> Generator::positions() const {
     auto result = std::vector<std::vector<double>>(m_graph.size());
-    for(int i=0; i<m_graph.size(); ++i)
+    for(std::size_t i=0; i<m_graph.size(); ++i)
         result[i] = m_graph[i].coord;
     return result;
 }
 
 
-double Generator::estimateWeightScalingThreshold(const std::vector<double>& weights, double desiredAvgDegree, int dimension) const {
+double Generator::estimateWeightScalingThreshold(std::vector<double> weights, double desiredAvgDegree, int dimension) const {
 
     // compute some constant stuff
-    auto max_weight = *std::max_element(weights.begin(), weights.end());
-    auto W = 0.0, sq_W = 0.0;
-    for(auto each : weights){
-        W += each;
-        sq_W += each*each;
-    }
+    const auto n = static_cast<long long>(weights.size());
+    const auto sums = blockedSums<2>(n, [&weights](std::array<double, 2>& acc, long long i) {
+        acc[0] += weights[i];
+        acc[1] += weights[i]*weights[i];
+    });
+    const auto W = sums[0], sq_W = sums[1];
+    const auto max_weight = *std::max_element(weights.begin(), weights.end());
+    auto sorted = DescendingWeights(std::move(weights), 0.0);
 
     // my function to do the exponential search on
-    auto f = [W, sq_W, &weights, dimension, max_weight](double c) {
-        // compute rich club
-        std::vector<double> rich_club;
-        for(auto weight : weights)
-            if(std::pow(2*c,dimension) * (weight*max_weight/W) > 1.0)
-                rich_club.push_back(weight);
-        sort(rich_club.begin(), rich_club.end(), std::greater<double>());
+    auto f = [W, sq_W, &sorted, n, dimension, max_weight](double c) {
+        const auto K = std::pow(2*c, dimension);
+
+        // rich club: all weights w with K*w*w_max/W > 1
+        const auto rich_club = static_cast<long long>(sorted.sortGreater(W / (K*max_weight)));
+
         // compute overestimation
-        auto overestimation = pow(2, dimension) * pow(c, dimension) * (W - sq_W/W);
-        // subtract error
-        auto error = 0.0;
-        for(int i = 0; i<rich_club.size(); ++i)
-            for(int j = 0; j<rich_club.size(); ++j) {
-                if(i==j) continue;
-                auto w1 = rich_club[i];
-                auto w2 = rich_club[j];
-                auto e = std::max( std::pow(2*c,dimension)*(w1*w2/W)-1.0, 0.0);
-                error += e;
-                if(e <= 0) break;
-            }
-        return (overestimation - error) / weights.size();
+        auto overestimation = K * (W - sq_W/W);
+
+        // subtract error, i.e. sum over all u != v in the rich club with K*wu*wv/W > 1 of K*wu*wv/W-1
+        // the v for a fixed u are a prefix of the sorted weights, so the inner sum follows from prefix sums
+        auto error = blockedSums<1>(rich_club, [&sorted, K, W](std::array<double, 1>& acc, long long i) {
+            const auto wi = sorted.weight(i);
+            const auto m = static_cast<long long>(sorted.countGreater(W / (K*wi)));
+            const auto self = i < m ? 1 : 0;
+            acc[0] += K * wi * (sorted.prefixSum(m) - self*wi) / W - (m - self);
+        })[0];
+        return (overestimation - error) / n;
     };
 
     // do exponential search on expected average degree function
@@ -236,74 +449,72 @@ double Generator::estimateWeightScalingThreshold(const std::vector<double>& weig
     return pow(estimated_c, dimension); // return scaling
 }
 
-double Generator::estimateWeightScaling(const std::vector<double> &weights, double desiredAvgDegree, int dimension, double alpha) const {
+double Generator::estimateWeightScaling(std::vector<double> weights, double desiredAvgDegree, int dimension, double alpha) const {
 
     using namespace std;
 
     assert(alpha != 1.0); // somehow breaks for alpha 1.0
 
     // compute some constant stuff
-    auto W = std::accumulate(weights.begin(), weights.end(), 0.0);
-    auto sum_sq_w   = 0.0; // sum_{v\in V} (w_v^2/W)
-    auto sum_w_a    = 0.0; // sum_{v\in V} (w_v  /W)^\alpha
-    auto sum_sq_w_a = 0.0; // sum_{v\in V} (w_v^2/W)^\alpha
-    for(auto each : weights){
-        sum_sq_w   += each*each/W;
-        sum_w_a    += pow(each/W, alpha);
-        sum_sq_w_a += pow(each*each/W, alpha);
-    }
-
     //   sum_{u\in V} sum_{v\in V} (wu*wv/W)^\alpha
-    // = sum_{u\in V} sum_{v\in V} wu^\alpha * (wv/W)^\alpha
     // = sum_{u\in V} wu^\alpha sum_{v\in V} (wv/W)^\alpha
-    auto sum_wwW_a = 0.0;
-    for(auto each : weights)
-        sum_wwW_a += pow(each, alpha)*sum_w_a;
+    // = W^{-\alpha} (sum_{v\in V} wv^\alpha)^2
+    // and sum_{v\in V} (w_v^2/W)^\alpha = W^{-\alpha} sum_{v\in V} (wv^\alpha)^2
+    const auto n = static_cast<long long>(weights.size());
+    const auto sums = blockedSums<4>(n, [&weights, alpha](std::array<double, 4>& acc, long long i) {
+        const auto w_a = pow(weights[i], alpha);
+        acc[0] += weights[i];
+        acc[1] += weights[i]*weights[i];
+        acc[2] += w_a;
+        acc[3] += w_a*w_a;
+    });
+    const auto W = sums[0];
+    const auto W_a = pow(W, alpha);
+    auto sum_sq_w   = sums[1] / W;   // sum_{v\in V} (w_v^2/W)
+    auto sum_sq_w_a = sums[3] / W_a; // sum_{v\in V} (w_v^2/W)^\alpha
+    auto sum_wwW_a  = sums[2] * sums[2] / W_a;
 
     auto factor1 = (W-sum_sq_w) * (1+1/(alpha-1)) * (1<<dimension);
     auto factor2 = pow(2, alpha*dimension) / (alpha-1) * (sum_wwW_a - sum_sq_w_a);
 
-    // my function to do the exponential search on
-    auto sorted_weights = weights;
-    sort(sorted_weights.begin(), sorted_weights.end(), greater<double>());
+    const auto w_n = *max_element(weights.begin(), weights.end());
+    auto sorted = DescendingWeights(std::move(weights), alpha);
 
-    auto f = [alpha, dimension, W, factor1, factor2, &sorted_weights](double c) {
+    // my function to do the exponential search on
+    auto f = [alpha, dimension, W, W_a, w_n, n, factor1, factor2, &sorted](double c) {
         auto d = dimension;
         auto a = alpha;
+        auto c_a = pow(c, 1/a);
 
         // as originally in Marianne's thesis
-        auto long_and_short_with_error = pow(c, 1/a) * factor1 - c * factor2;
-
-        // get error for long and short edges
-        auto n = sorted_weights.size();
-        auto short_error = 0.0;
-        auto long_error = 0.0;
-
-        // get rich club
-        vector<double> rich_club;
-        auto w_n = sorted_weights.front();
-        for(int i=0; i<n; ++i){
-            auto crazy_w = pow(c, 1/a/d) * pow(sorted_weights[i] * w_n / W, 1.0/d);
-            if(crazy_w > 0.5)
-                rich_club.push_back(sorted_weights[i]);
-            else
-                break;
-        }
-
-        // compute errors
-        for(int i = 0; i<rich_club.size(); ++i) {
-            for (int j = 0; j < rich_club.size(); ++j) {
-                if (i == j) continue;
+        auto long_and_short_with_error = c_a * factor1 - c * factor2;
+
+        // A pair u,v contributes an error if crazy_w = (c^{1/a} wu*wv/W)^{1/d} > 0.5, i.e. c^{1/a} wu*wv/W > 0.5^d.
+        // The rich club are all nodes that have such a partner.
+        const auto half_d = pow(0.5, d);
+        const auto rich_club = static_cast<long long>(sorted.sortGreater(half_d * W / (c_a * w_n)));
+
+        // For a pair with w_term = wu*wv/W we have
+        //   short error: 2^d c^{1/a} w_term - 1
+        //   long error:  c w_term^a d 2^d/(d-ad) (0.5^{d-ad} - crazy_w^{d-ad})
+        //              = d 2^d/(d-ad) (c 0.5^{d-ad} w_term^a - c^{1/a} w_term)    as c w_term^a crazy_w^{d-ad} = c^{1/a} w_term
+        // so summing over the partners of u only requires prefix sums of w and w^a.
+        const auto long_factor = d * (1 << d) / (d - a * d);
+        const auto long_factor_a = c * pow(0.5, d - a * d) / W_a;
+        const auto errors = blockedSums<2>(rich_club, [&](std::array<double, 2>& acc, long long i) {
+            const auto wi = sorted.weight(i);
+            const auto wi_a = pow(wi, a);
+            const auto m = static_cast<long long>(sorted.countGreater(half_d * W / (c_a * wi)));
+            const auto self = i < m ? 1 : 0;
+            const auto sum_w = sorted.prefixSum(m) - self * wi;
+            const auto sum_w_a = sorted.prefixPowSum(m) - self * wi_a;
+
+            acc[0] += (1<<d) * c_a * wi * sum_w / W - (m - self);
+            acc[1] += long_factor * (long_factor_a * wi_a * sum_w_a - c_a * wi * sum_w / W);
+        });
+        const auto short_error = errors[0];
+        const auto long_error = errors[1];
 
-                auto w_term = rich_club[i] * rich_club[j] / W;
-                auto crazy_w = pow(c, 1 / a / d) * pow(w_term, 1.0 / d);
-                if (crazy_w <= 0.5)
-                    break;
-
-                short_error += (1<<d)*pow(c, 1/a)*w_term -1.0;
-                long_error += c * pow(w_term, a) * d * (1 << d) / (d - a * d) * (pow(0.5, d - a * d) - pow(crazy_w, d - a * d));
-            }
-        }
         return (long_and_short_with_error - short_error - long_error)/n;
     };
 
@@ -0,0 +1,41 @@
+#include <girgs/Tracer.h>
+
+#include <fstream>
+#include <stdexcept>
+
+
+namespace girgs {
+
+
+Tracer::Tracer()
+: m_epoch(omp_get_wtime())
+, m_maxLevel(-1)
+{
+}
+
+Tracer& Tracer::global() {
+    static Tracer tracer;
+    return tracer;
+}
+
+void Tracer::write(const std::string& file) const {
+    auto f = std::ofstream(file);
+    f << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    auto first = true;
+    for (auto thread = 0; thread < threads(); ++thread) {
+        for (auto& event : events(thread)) {
+            f << (first ? "" : ",\n")
+              << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread
+              << ",\"ts\":" << event.begin << ",\"dur\":" << event.duration
+              << ",\"args\":{\"level\":" << event.level << ",\"cell\":" << event.cell
+              << ",\"points\":" << event.points << ",\"edges\":" << event.edges << "}}";
+            first = false;
+        }
+    }
+    f << "\n]}\n";
+    if (!f)
+        throw std::runtime_error("cannot write " + file);
+}
+
+
+} // namespace girgs
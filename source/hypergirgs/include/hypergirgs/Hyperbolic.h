@@ -5,6 +5,8 @@
 #include <cmath>
 #include <random>
 
+#include <hypergirgs/GenerationStats.h>
+#include <hypergirgs/IndexTypes.h>
 #include <hypergirgs/hypergirgs_api.h>
 
 
@@ -14,11 +16,11 @@ constexpr double PI = 3.14159265358979323846;
 
 using default_random_engine = std::mt19937_64;
 
-HYPERGIRGS_API double calculateRadius(int n, double alpha, double T, int deg);
+HYPERGIRGS_API double calculateRadius(NodeIndex n, double alpha, double T, int deg);
 HYPERGIRGS_API double hyperbolicDistance(double r1, double phi1, double r2, double phi2);
 
-HYPERGIRGS_API std::vector<double> sampleRadii(int n, double alpha, double R, int seed);
-HYPERGIRGS_API std::vector<double> sampleAngles(int n, int seed);
-HYPERGIRGS_API std::vector<std::pair<int, int> > generateEdges(std::vector<double>& radii, std::vector<double>& angles, double T, double R, int seed = 0);
+HYPERGIRGS_API std::vector<double> sampleRadii(NodeIndex n, double alpha, double R, int seed);
+HYPERGIRGS_API std::vector<double> sampleAngles(NodeIndex n, int seed);
+HYPERGIRGS_API std::vector<std::pair<NodeIndex, NodeIndex> > generateEdges(std::vector<double>& radii, std::vector<double>& angles, double T, double R, int seed = 0, GenerationStats* stats = nullptr);
 
 } // namespace hypergirgs
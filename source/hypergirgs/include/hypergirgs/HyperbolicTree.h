@@ -1,10 +1,12 @@
 #pragma once
 
 #include <vector>
+#include <cmath>
 #include <utility>
 #include <random>
 
 #include <hypergirgs/AngleHelper.h>
+#include <hypergirgs/GenerationStats.h>
 #include <hypergirgs/RadiusLayer.h>
 #include <hypergirgs/Point.h>
 
@@ -21,17 +23,54 @@ public:
 
     void generate(int seed);
 
+    /**
+     * @brief
+     *  Enables the collection of statistics during generate.
+     *
+     * @param stats
+     *  Is reset and filled by each call of generate. Nullptr (the default) disables the collection.
+     */
+    void setStatistics(GenerationStats* stats) { m_stats = stats; }
+
 protected:
 
 
-    void visitCellPair(unsigned int cellA, unsigned int cellB, unsigned int level);
+    void visitCellPair(CellIndex cellA, CellIndex cellB, unsigned int level);
+
+    /**
+     * @brief
+     *  Same as visitCellPair but stops the recursion in first_parallel_level.
+     *  Instead, the calls that would be made in this level are saved in parallel_calls,
+     *  grouped by their (level local) cellA parameter.
+     *  The recursion that is not sawn off is done sequentially by the calling thread.
+     *
+     * @param first_parallel_level
+     *  The level in which the recursion is stopped. To get sufficient parallel cells this should
+     *  be computed as \f$ 2^l \geq kt \f$ solved for l (t threads, k tuning parameter).
+     * @param parallel_calls
+     *  Outer size must be the number of cells in first_parallel_level.
+     */
+    void visitCellPair_sequentialStart(CellIndex cellA, CellIndex cellB, unsigned int level,
+            unsigned int first_parallel_level, std::vector<std::vector<CellIndex>>& parallel_calls);
 
-    void sampleTypeI(unsigned int cellA, unsigned int cellB, unsigned int level, unsigned int i, unsigned int j);
+    void sampleTypeI(CellIndex cellA, CellIndex cellB, unsigned int level, unsigned int i, unsigned int j);
 
-    void sampleTypeII(unsigned int cellA, unsigned int cellB, unsigned int level, unsigned int i, unsigned int j);
+    void sampleTypeII(CellIndex cellA, CellIndex cellB, unsigned int level, unsigned int i, unsigned int j);
 
     unsigned int partitioningBaseLevel(double r1, double r2); // takes lower bound on radius for two layers
 
+    /**
+     * @brief
+     *  Lower bound on the hyperbolic distance of two points in the layers i and j
+     *  whose angular difference is at least angleDiff.
+     */
+    double distanceLowerBound(unsigned int i, unsigned int j, double angleDiff) const;
+
+    /// connection probability of two points with hyperbolic distance dist (only for T > 0)
+    double connectionProb(double dist) const noexcept {
+        return 1.0 / (1.0 + std::exp((dist - m_R) * m_halfInvT));
+    }
+
 
 protected:
     EdgeCallback& m_edgeCallback;
@@ -42,6 +81,7 @@ protected:
 
     const double m_T;
     const double m_R;
+    const double m_halfInvT; ///< = 1/(2T) or 0 in the threshold model
 
     unsigned int m_layers; ///< number of layers
     unsigned int m_levels; ///< number of levels
@@ -49,12 +89,15 @@ protected:
     std::vector<RadiusLayer> m_radius_layers;
     std::vector<std::vector<std::pair<unsigned int, unsigned int>>> m_layer_pairs;
 
-    hypergirgs::default_random_engine m_gen; ///< random generator
-    std::uniform_real_distribution<> m_dist; ///< random distribution
+    std::vector<hypergirgs::default_random_engine> m_gens; ///< random generators for each thread
+    std::vector<std::uniform_real_distribution<>> m_dists; ///< random distributions for each thread
+
+    double m_buildSeconds;              ///< time to build the radius layers in the constructor
+    GenerationStats* m_stats = nullptr; ///< statistics to fill or nullptr (see setStatistics)
 
 #ifndef NDEBUG
-    long long m_type1_checks; ///< number of node pairs per thread that are checked via a type 1 check
-    long long m_type2_checks; ///< number of node pairs per thread that are checked via a type 2 check
+    std::vector<long long> m_type1_checks; ///< number of node pairs per thread that are checked via a type 1 check
+    std::vector<long long> m_type2_checks; ///< number of node pairs per thread that are checked via a type 2 check
 #endif // NDEBUG
 };
 
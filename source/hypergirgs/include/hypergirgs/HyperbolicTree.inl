@@ -1,5 +1,6 @@
 
 #include <cassert>
+#include <numeric>
 #include <omp.h>
 
 #include <hypergirgs/Hyperbolic.h>
@@ -14,26 +15,22 @@ HyperbolicTree<EdgeCallback>::HyperbolicTree(std::vector<double> &radii, std::ve
 , m_coshR(std::cosh(R))
 , m_T(T)
 , m_R(R)
-, m_gen()
-, m_dist()
-#ifndef NDEBUG
-, m_type1_checks(0)
-, m_type2_checks(0)
-#endif // NDEBUG
+, m_halfInvT(T > 0 ? 0.5 / T : 0.0)
 {
     assert(radii.size() == angles.size());
+    const auto buildStart = omp_get_wtime();
 
     // pre-compute values for distance
     std::vector<Point> pre_points(radii.size());
     #pragma omp parallel for if (m_n > 10000)
-    for (int i = 0; i < radii.size(); ++i) {
+    for (NodeIndex i = 0; i < static_cast<NodeIndex>(radii.size()); ++i) {
         pre_points[i] = Point(i, radii[i], angles[i]);
     }
 
     // create layer
     m_layers = static_cast<unsigned int>(std::ceil(R));
-    auto weightLayerNodes = std::vector<std::vector<int>>(m_layers);
-    for(auto i = 0u; i < radii.size(); ++i) // layer i has nodes from (R-i-1 to R-i]
+    auto weightLayerNodes = std::vector<std::vector<NodeIndex>>(m_layers);
+    for(NodeIndex i = 0; i < static_cast<NodeIndex>(radii.size()); ++i) // layer i has nodes from (R-i-1 to R-i]
         weightLayerNodes[static_cast<unsigned int>(R-radii[i])].push_back(i);
 
     // ignore empty layers of higher radius
@@ -52,18 +49,79 @@ HyperbolicTree<EdgeCallback>::HyperbolicTree(std::vector<double> &radii, std::ve
     for (auto i = 0u; i < m_layers; ++i)
         for (auto j = 0u; j < m_layers; ++j)
             m_layer_pairs[partitioningBaseLevel(m_radius_layers[i].m_r_min, m_radius_layers[j].m_r_min)].emplace_back(i,j);
+
+    m_buildSeconds = omp_get_wtime() - buildStart;
 }
 
 template <typename EdgeCallback>
 void HyperbolicTree<EdgeCallback>::generate(int seed) {
-    m_gen.seed(seed >= 0 ? seed : std::random_device{}());
-    m_dist.reset();
-    visitCellPair(0,0,0);
-    assert(m_type1_checks + m_type2_checks == static_cast<long long>(m_n-1) * m_n);
+    // one random generator and distribution for each thread
+    const auto num_threads = omp_get_max_threads();
+    m_gens.resize(num_threads);
+    m_dists.resize(num_threads);
+    for (int thread = 0; thread < num_threads; thread++) {
+        m_gens[thread].seed(seed >= 0 ? seed+thread : std::random_device{}());
+        m_dists[thread].reset();
+    }
+
+#ifndef NDEBUG
+    // ensure that all node pairs are compared either type 1 or type 2
+    m_type1_checks.assign(num_threads, 0);
+    m_type2_checks.assign(num_threads, 0);
+#endif // NDEBUG
+
+    // the time of each phase is only recorded with statistics
+    auto phaseStart = omp_get_wtime();
+    auto endPhase = [this, &phaseStart](double GenerationStats::* phase) {
+        if (!m_stats)
+            return;
+        const auto now = omp_get_wtime();
+        m_stats->*phase = now - phaseStart;
+        phaseStart = now;
+    };
+    if (m_stats) {
+        m_stats->reset(num_threads, m_levels);
+        m_stats->buildSeconds = m_buildSeconds;
+    }
+
+    // sample all edges
+    if (num_threads == 1) {
+        // sequential
+        visitCellPair(0, 0, 0);
+        endPhase(&GenerationStats::sequentialSeconds);
+    } else {
+        // parallel see docs for visitCellPair_sequentialStart
+        const auto first_parallel_level = static_cast<unsigned int>(std::ceil(std::log2(4.0*num_threads)));
+        const auto parallel_cells = AngleHelper::numCellsInLevel(first_parallel_level);
+        const auto first_parallel_cell = AngleHelper::firstCellOfLevel(first_parallel_level);
+
+        // saw off recursion before "first_parallel_level" and save all calls that would be made
+        auto parallel_calls = std::vector<std::vector<CellIndex>>(parallel_cells);
+        visitCellPair_sequentialStart(0, 0, 0, first_parallel_level, parallel_calls);
+        endPhase(&GenerationStats::sequentialSeconds);
+
+        // do the collected calls in parallel
+        #pragma omp parallel for schedule(static), num_threads(num_threads) // dynamic scheduling would be better but not reproducible
+        for (int i = 0; i < static_cast<int>(parallel_cells); ++i) {
+            auto current_cell = first_parallel_cell + i;
+            for (auto each : parallel_calls[i])
+                visitCellPair(current_cell, each, first_parallel_level);
+        }
+        endPhase(&GenerationStats::parallelSeconds);
+    }
+
+#ifndef NDEBUG
+    // after sampling the graph the sum of type 1 and type 2 checks should always be n(n-1) to ensure that all edges were considered
+    auto type1 = std::accumulate(m_type1_checks.begin(), m_type1_checks.end(), 0ll);
+    auto type2 = std::accumulate(m_type2_checks.begin(), m_type2_checks.end(), 0ll);
+    assert(type1 + type2 == static_cast<long long>(m_n-1) * m_n);
+#endif // NDEBUG
 }
 
 template <typename EdgeCallback>
-void HyperbolicTree<EdgeCallback>::visitCellPair(unsigned int cellA, unsigned int cellB, unsigned int level) {
+void HyperbolicTree<EdgeCallback>::visitCellPair(CellIndex cellA, CellIndex cellB, unsigned int level) {
+    if (m_stats)
+        m_stats->countVisit(omp_get_thread_num(), level);
 
     if(!AngleHelper::touching(cellA, cellB, level))
     {   // not touching cells
@@ -98,25 +156,77 @@ void HyperbolicTree<EdgeCallback>::visitCellPair(unsigned int cellA, unsigned in
 }
 
 template <typename EdgeCallback>
-void HyperbolicTree<EdgeCallback>::sampleTypeI(unsigned int cellA, unsigned int cellB, unsigned int level, unsigned int i, unsigned int j) {
+void HyperbolicTree<EdgeCallback>::visitCellPair_sequentialStart(CellIndex cellA, CellIndex cellB, unsigned int level,
+                                                                 unsigned int first_parallel_level,
+                                                                 std::vector<std::vector<CellIndex>>& parallel_calls) {
+    if (m_stats)
+        m_stats->countVisit(omp_get_thread_num(), level);
+
+    if(!AngleHelper::touching(cellA, cellB, level))
+    {   // not touching cells
+        // sample all type 2 occurrences with this cell pair
+        for(auto l=level; l<m_levels; ++l)
+            for(auto& layer_pair : m_layer_pairs[l])
+                sampleTypeII(cellA, cellB, level, layer_pair.first, layer_pair.second);
+        return;
+    }
+
+    // touching cells
+
+    // sample all type 1 occurrences with this cell pair
+    for(auto& layer_pair : m_layer_pairs[level]){
+        if(cellA != cellB || layer_pair.first <= layer_pair.second)
+            sampleTypeI(cellA, cellB, level, layer_pair.first, layer_pair.second);
+    }
+
+    // break if last level reached
+    if(level == m_levels-1) // if we are at the last level we don't need recursive calls
+        return;
+
+    // recursive call for all children pairs (a,b) where a in A and b in B
+    // in first_parallel_level these are saved instead of executed
+    const auto fA = AngleHelper::firstChild(cellA);
+    const auto fB = AngleHelper::firstChild(cellB);
+    const std::pair<CellIndex, CellIndex> children[] = {{fA + 0, fB + 0}, {fA + 0, fB + 1}, {fA + 1, fB + 1}, {fA + 1, fB + 0}};
+    const auto num_children = (cellA != cellB) ? 4 : 3; // if A==B the last call is the same as the first
+    for(auto k = 0; k < num_children; ++k) {
+        if(level+1 == first_parallel_level)
+            parallel_calls[children[k].first - AngleHelper::firstCellOfLevel(first_parallel_level)].push_back(children[k].second);
+        else
+            visitCellPair_sequentialStart(children[k].first, children[k].second, level+1, first_parallel_level, parallel_calls);
+    }
+}
+
+template <typename EdgeCallback>
+void HyperbolicTree<EdgeCallback>::sampleTypeI(CellIndex cellA, CellIndex cellB, unsigned int level, unsigned int i, unsigned int j) {
     auto rangeA = m_radius_layers[i].cellIterators(cellA, level);
     auto rangeB = m_radius_layers[j].cellIterators(cellB, level);
 
     if (rangeA.first == rangeA.second || rangeB.first == rangeB.second)
         return;
 
+    const auto threadId = omp_get_thread_num();
+
+    if (m_stats) {
+        const auto sizeV_i_A = static_cast<std::uint64_t>(std::distance(rangeA.first, rangeA.second));
+        const auto sizeV_j_B = static_cast<std::uint64_t>(std::distance(rangeB.first, rangeB.second));
+        m_stats->threads[threadId].typeIPairs += (cellA == cellB && i == j) ? sizeV_i_A * (sizeV_i_A - 1) / 2 // all pairs in AxA without {v,v}
+                                                                            : sizeV_i_A * sizeV_j_B;           // all pairs in AxB
+    }
+
 #ifndef NDEBUG
     {
         const auto sizeV_i_A = std::distance(rangeA.first, rangeA.second);
         const auto sizeV_j_B = std::distance(rangeB.first, rangeB.second);
-        m_type1_checks += (cellA == cellB && i == j) ? sizeV_i_A * (sizeV_i_A - 1)  // all pairs in AxA without {v,v}
+        m_type1_checks[threadId] += (cellA == cellB && i == j) ? sizeV_i_A * (sizeV_i_A - 1)  // all pairs in AxA without {v,v}
                                                      : sizeV_i_A * sizeV_j_B * 2; // all pairs in AxB and BxA
     }
 #endif // NDEBUG
 
-    const auto threadId = omp_get_thread_num();
+    auto& gen = m_gens[threadId];
+    auto& dist = m_dists[threadId];
 
-    int kA = 0;
+    NodeIndex kA = 0;
     for(auto pointerA = rangeA.first; pointerA != rangeA.second; ++kA, ++pointerA) {
         auto offset = (cellA == cellB && i==j) ? kA+1 : 0;
         for (auto pointerB = rangeB.first + offset; pointerB != rangeB.second; ++pointerB) {
@@ -136,8 +246,12 @@ void HyperbolicTree<EdgeCallback>::sampleTypeI(unsigned int cellA, unsigned int
             assert(m_radius_layers[j].m_r_min < nodeInB.radius && nodeInB.radius <= m_radius_layers[j].m_r_max);
 
             assert(nodeInA != nodeInB);
-            if (nodeInA.isDistanceBelowR(nodeInB, m_coshR)) {
-                assert(hyperbolicDistance(nodeInA.radius, nodeInA.angle, nodeInB.radius, nodeInB.angle) < m_R);
+            if (m_T == 0) {
+                if (nodeInA.isDistanceBelowR(nodeInB, m_coshR)) {
+                    assert(hyperbolicDistance(nodeInA.radius, nodeInA.angle, nodeInB.radius, nodeInB.angle) < m_R);
+                    m_edgeCallback(nodeInA.id, nodeInB.id, threadId);
+                }
+            } else if (dist(gen) < connectionProb(nodeInA.distance(nodeInB))) {
                 m_edgeCallback(nodeInA.id, nodeInB.id, threadId);
             }
         }
@@ -145,22 +259,94 @@ void HyperbolicTree<EdgeCallback>::sampleTypeI(unsigned int cellA, unsigned int
 }
 
 template <typename EdgeCallback>
-void HyperbolicTree<EdgeCallback>::sampleTypeII(unsigned int cellA, unsigned int cellB, unsigned int level, unsigned int i, unsigned int j) {
+void HyperbolicTree<EdgeCallback>::sampleTypeII(CellIndex cellA, CellIndex cellB, unsigned int level, unsigned int i, unsigned int j) {
 
     auto sizeV_i_A = m_radius_layers[i].pointsInCell(cellA, level);
     auto sizeV_j_B = m_radius_layers[j].pointsInCell(cellB, level);
     if (sizeV_i_A == 0 || sizeV_j_B == 0)
         return;
 
+    const auto threadId = omp_get_thread_num();
+
 #ifndef NDEBUG
-    m_type2_checks += 2llu * sizeV_i_A * sizeV_j_B;
+    m_type2_checks[threadId] += 2llu * sizeV_i_A * sizeV_j_B;
 #endif // NDEBUG
 
     if (m_T == 0)
         return;
 
-    // TODO add content
+    // get upper bound for probability
+    const auto dist_lower_bound = distanceLowerBound(i, j, AngleHelper::dist(cellA, cellB, level));
+    const auto max_connection_prob = connectionProb(dist_lower_bound);
+
+    // if we must sample all pairs we treat this as type 1 sampling
+    // also, 1.0 is no valid prob for a geometric dist (see c++ std)
+    if (max_connection_prob == 1.0) {
+#ifndef NDEBUG
+        m_type2_checks[threadId] -= 2llu * sizeV_i_A * sizeV_j_B;
+#endif // NDEBUG
+        sampleTypeI(cellA, cellB, level, i, j);
+        return;
+    }
+
+    // skipping over points that certainly do not connect
+    if (max_connection_prob <= 1e-10)
+        return;
 
+    auto& gen = m_gens[threadId];
+    auto& dist = m_dists[threadId];
+    const auto num_pairs = static_cast<unsigned long long>(sizeV_i_A) * sizeV_j_B;
+    auto geo = std::geometric_distribution<unsigned long long>(max_connection_prob);
+    auto candidates = std::uint64_t(0);
+    auto accepted = std::uint64_t(0);
+    for (auto r = geo(gen); r < num_pairs; r += 1 + geo(gen)) {
+        ++candidates;
+        // determine the r-th pair
+        const auto& nodeInA = m_radius_layers[i].kthPoint(cellA, level, r % sizeV_i_A);
+        const auto& nodeInB = m_radius_layers[j].kthPoint(cellB, level, r / sizeV_i_A);
+
+        // points are in correct weight layer
+        assert(m_radius_layers[i].m_r_min < nodeInA.radius && nodeInA.radius <= m_radius_layers[i].m_r_max);
+        assert(m_radius_layers[j].m_r_min < nodeInB.radius && nodeInB.radius <= m_radius_layers[j].m_r_max);
+
+        // get actual connection probability
+        const auto connection_prob = connectionProb(nodeInA.distance(nodeInB));
+        assert(connection_prob <= max_connection_prob * (1.0 + 1e-10));
+
+        if (dist(gen) < connection_prob / max_connection_prob) {
+            m_edgeCallback(nodeInA.id, nodeInB.id, threadId);
+            ++accepted;
+        }
+    }
+
+    if (m_stats) {
+        m_stats->threads[threadId].typeIICandidates += candidates;
+        m_stats->threads[threadId].typeIIAccepted += accepted;
+    }
+}
+
+template <typename EdgeCallback>
+double HyperbolicTree<EdgeCallback>::distanceLowerBound(unsigned int i, unsigned int j, double angleDiff) const {
+    // for an angular difference of at least angleDiff, cosh(d) is bounded from below by
+    // f(r1,r2) = cosh(r1)cosh(r2) - sinh(r1)sinh(r2)cos(angleDiff). With fixed r1, f is convex in r2 and
+    // minimal at atanh(cos(angleDiff)tanh(r1)) (and vice versa). The only stationary point of f is the
+    // origin, so the minimum over the box of radii is attained at the boundary which we check edge by edge.
+    const auto cosDiff = std::cos(std::min(angleDiff, PI));
+    const auto minOnEdge = [cosDiff] (double fixed, double lo, double hi) {
+        const auto best = std::min(std::max(std::atanh(cosDiff * std::tanh(fixed)), lo), hi);
+        return std::cosh(fixed) * std::cosh(best) - std::sinh(fixed) * std::sinh(best) * cosDiff;
+    };
+
+    const auto& layerA = m_radius_layers[i];
+    const auto& layerB = m_radius_layers[j];
+    const auto loA = std::max(0.0, layerA.m_r_min), hiA = layerA.m_r_max;
+    const auto loB = std::max(0.0, layerB.m_r_min), hiB = layerB.m_r_max;
+
+    const auto coshDist = std::min(
+        std::min(minOnEdge(loA, loB, hiB), minOnEdge(hiA, loB, hiB)),
+        std::min(minOnEdge(loB, loA, hiA), minOnEdge(hiB, loA, hiA)));
+
+    return std::acosh(std::max(1.0, coshDist));
 }
 
 template <typename EdgeCallback>
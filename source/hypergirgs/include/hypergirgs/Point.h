@@ -1,15 +1,17 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 
 #include <hypergirgs/Hyperbolic.h>
+#include <hypergirgs/IndexTypes.h>
 
 namespace hypergirgs {
 
 struct Point {
     Point() {}; // prevent initialization of members
-    Point(const int id, const double radius, const double angle) :
+    Point(const NodeIndex id, const double radius, const double angle) :
           id{id}
         , invsinh_r{1.0 / std::sinh(radius)}
         , coth_r{std::cosh(radius) / std::sinh(radius)}
@@ -34,6 +36,13 @@ struct Point {
             coth_r * pt.coth_r - coshR * invsinh_r * pt.invsinh_r;
     }
 
+    /// Hyperbolic distance between this point and point pt. (Useful in the general model)
+    double distance(const Point& pt) const noexcept {
+        const auto cos_diff = cos_phi * pt.cos_phi + sin_phi * pt.sin_phi;
+        const auto cosh_dist = (coth_r * pt.coth_r - cos_diff) / (invsinh_r * pt.invsinh_r);
+        return std::acosh(std::max(1.0, cosh_dist));
+    }
+
     /// Check whether node ids match
     bool operator==(const Point& o) const noexcept {
         return id == o.id;
@@ -44,7 +53,7 @@ struct Point {
         return id != o.id;
     }
 
-    int    id;        ///< node id
+    NodeIndex id;     ///< node id
 
     double invsinh_r; ///< = 1.0 / sinh(radius)
     double coth_r;    ///< = coth(radius) = cosh(radius) / sinh(radius)
@@ -5,6 +5,7 @@
 #include <vector>
 
 #include <hypergirgs/AngleHelper.h>
+#include <hypergirgs/IndexTypes.h>
 #include <hypergirgs/Point.h>
 
 #include <hypergirgs/hypergirgs_api.h>
@@ -19,11 +20,11 @@ public:
 	RadiusLayer() = delete;
 
 	RadiusLayer(double r_min, double r_max, unsigned int targetLevel,
-				const std::vector<int> &nodes, const std::vector<double> &angles,
+				const std::vector<NodeIndex> &nodes, const std::vector<double> &angles,
 				const std::vector<Point> &points);
 
 
-    int pointsInCell(unsigned int cell, unsigned int level) const {
+    NodeIndex pointsInCell(CellIndex cell, unsigned int level) const {
         auto cellBoundaries = levelledCell(cell, level);
         assert(cellBoundaries.first  + AngleHelper::firstCellOfLevel(level) < AngleHelper::firstCellOfLevel(m_target_level+1));
         assert(cellBoundaries.second + AngleHelper::firstCellOfLevel(level) < AngleHelper::firstCellOfLevel(m_target_level+1));
@@ -31,17 +32,17 @@ public:
         return m_prefix_sums[cellBoundaries.second+1] - m_prefix_sums[cellBoundaries.first];
     }
 
-    const Point& kthPoint(unsigned int cell, unsigned int level, int k) const {
+    const Point& kthPoint(CellIndex cell, unsigned int level, NodeIndex k) const {
         auto cellBoundaries = levelledCell(cell, level);
         return m_points[m_prefix_sums[cellBoundaries.first] + k];
     }
 
-    const Point* firstPointPointer(unsigned int cell, unsigned int level) const {
+    const Point* firstPointPointer(CellIndex cell, unsigned int level) const {
         auto cellBoundaries = levelledCell(cell, level);
         return m_points.data() + m_prefix_sums[cellBoundaries.first];
     }
 
-    std::pair<const Point*, const Point*> cellIterators(unsigned int cell, unsigned int level) const {
+    std::pair<const Point*, const Point*> cellIterators(CellIndex cell, unsigned int level) const {
         auto cellBoundaries = levelledCell(cell, level);
         const auto* base = m_points.data();
         return {base + m_prefix_sums[cellBoundaries.first],
@@ -55,10 +56,10 @@ public:
     const unsigned int m_target_level;
 
 protected:
-    std::vector<int>   m_prefix_sums;       ///< for each cell c in target level: the sum of points of this layer in all cells <c
+    std::vector<NodeIndex> m_prefix_sums;   ///< for each cell c in target level: the sum of points of this layer in all cells <c
     std::vector<Point> m_points; 			///< vector of points in this layer
 
-    std::pair<unsigned int, unsigned int> levelledCell(unsigned int cell, unsigned int level) const {
+    std::pair<CellIndex, CellIndex> levelledCell(CellIndex cell, unsigned int level) const {
         assert(level <= m_target_level);
         assert(AngleHelper::firstCellOfLevel(level) <= cell && cell < AngleHelper::firstCellOfLevel(level + 1)); // cell is from fromLevel
 
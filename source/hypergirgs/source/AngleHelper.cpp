@@ -8,26 +8,26 @@
 namespace hypergirgs {
 
 
-std::pair<double, double> AngleHelper::bounds(unsigned int cell, unsigned int level) {
-    auto diameter = 2*PI / (1<<level);
+std::pair<double, double> AngleHelper::bounds(CellIndex cell, unsigned int level) {
+    auto diameter = 2*PI / numCellsInLevel(level);
     auto localIndex = cell - firstCellOfLevel(level);
     return {localIndex*diameter, (localIndex+1) * diameter};
 }
 
-unsigned int AngleHelper::cellForPoint(double angle, unsigned int targetLevel) {
-    return static_cast<unsigned int>(angle/2/PI * numCellsInLevel(targetLevel));
+CellIndex AngleHelper::cellForPoint(double angle, unsigned int targetLevel) {
+    return static_cast<CellIndex>(angle/2/PI * numCellsInLevel(targetLevel));
 }
 
-bool AngleHelper::touching(unsigned int cellA, unsigned int cellB, unsigned int level) {
+bool AngleHelper::touching(CellIndex cellA, CellIndex cellB, unsigned int level) {
     auto mm = std::minmax(cellA,cellB);
     auto diff = mm.second - mm.first;
     return diff<=1 || diff == numCellsInLevel(level) - 1;
 }
 
-double AngleHelper::dist(unsigned int cellA, unsigned int cellB, unsigned int level) {
+double AngleHelper::dist(CellIndex cellA, CellIndex cellB, unsigned int level) {
     auto mm = std::minmax(cellA,cellB);
-    auto diff = mm.second - mm.first;
-    return (diff <= 1) ? 0 : (diff-1) * 2.0*PI / (1<<level);
+    auto diff = std::min(mm.second - mm.first, numCellsInLevel(level) - (mm.second - mm.first)); // wrap around
+    return (diff <= 1) ? 0 : (diff-1) * 2.0*PI / numCellsInLevel(level);
 }
 
 
@@ -2,15 +2,22 @@
 #include <hypergirgs/Hyperbolic.h>
 #include <hypergirgs/HyperbolicTree.h>
 
+#include <algorithm>
 #include <random>
 #include <fstream>
 #include <cmath>
 
+#include <omp.h>
+
 
 namespace hypergirgs {
 
+// Sampling of radii and angles is split into blocks of this many nodes. Each block has its own random generator
+// seeded with the seed and the block index, so the result does not depend on the number of threads.
+constexpr NodeIndex c_samplingBlockSize = 1 << 13;
+
 
-double calculateRadius(int n, double alpha, double T, int deg) {
+double calculateRadius(NodeIndex n, double alpha, double T, int deg) {
     return 2 * log(n * 2 * alpha * alpha * (T == 0 ? 1 / PI : T / sin(PI * T)) /
                    (deg * (alpha - 0.5) * (alpha - 0.5)));
 }
@@ -19,45 +26,77 @@ double hyperbolicDistance(double r1, double phi1, double r2, double phi2) {
     return acosh(std::max(1., cosh(r1 - r2) + (1. - cos(phi1 - phi2)) * sinh(r1) * sinh(r2)));
 }
 
-std::vector<double> sampleRadii(int n, double alpha, double R, int seed) {
+std::vector<double> sampleRadii(NodeIndex n, double alpha, double R, int seed) {
     std::vector<double> result(n);
-    hypergirgs::default_random_engine gen(seed >= 0 ? seed : std::random_device()());
-    std::uniform_real_distribution<> dist; // [0..1)
+    const auto blockSeed = seed >= 0 ? seed : static_cast<int>(std::random_device()() >> 1);
 
     const auto invalpha = 1.0 / alpha;
     const auto factor = std::cosh(alpha * R) - 1.0;
-
-    for(int i = 0; i < n; ++i) {
-        auto p = dist(gen);
-        while(p == 0) p = dist(gen);
-        result[i] = acosh(p * factor + 1.0) * invalpha;
+    const auto num_blocks = static_cast<int>((n + c_samplingBlockSize - 1) / c_samplingBlockSize);
+
+    #pragma omp parallel for schedule(static)
+    for(int block = 0; block < num_blocks; ++block) {
+        std::seed_seq seq{blockSeed, block};
+        hypergirgs::default_random_engine gen(seq);
+        std::uniform_real_distribution<> dist; // [0..1)
+
+        const auto end = std::min(n, (block + 1) * c_samplingBlockSize);
+        for(auto i = block * c_samplingBlockSize; i < end; ++i) {
+            auto p = dist(gen);
+            while(p == 0) p = dist(gen);
+            result[i] = acosh(p * factor + 1.0) * invalpha;
+        }
     }
 
     return result;
 }
 
-std::vector<double> sampleAngles(int n, int seed) {
+std::vector<double> sampleAngles(NodeIndex n, int seed) {
     std::vector<double> result(n);
-    hypergirgs::default_random_engine gen(seed >= 0 ? seed : std::random_device()());
-    std::uniform_real_distribution<> dist(0.0, std::nextafter(2 * PI, 0.0));
-
-    for(int i = 0; i < n; ++i)
-        result[i] = dist(gen);
+    const auto blockSeed = seed >= 0 ? seed : static_cast<int>(std::random_device()() >> 1);
+    const auto num_blocks = static_cast<int>((n + c_samplingBlockSize - 1) / c_samplingBlockSize);
+
+    #pragma omp parallel for schedule(static)
+    for(int block = 0; block < num_blocks; ++block) {
+        std::seed_seq seq{blockSeed, block};
+        hypergirgs::default_random_engine gen(seq);
+        std::uniform_real_distribution<> dist(0.0, std::nextafter(2 * PI, 0.0));
+
+        const auto end = std::min(n, (block + 1) * c_samplingBlockSize);
+        for(auto i = block * c_samplingBlockSize; i < end; ++i)
+            result[i] = dist(gen);
+    }
 
     return result;
 }
 
-std::vector<std::pair<int, int> > generateEdges(std::vector<double>& radii, std::vector<double>& angles, double T, double R, int seed) {
-    std::vector<std::pair<int,int>> graph;
+std::vector<std::pair<NodeIndex, NodeIndex> > generateEdges(std::vector<double>& radii, std::vector<double>& angles, double T, double R, int seed, GenerationStats* stats) {
+    // one edge buffer per thread, they are concatenated afterwards
+    const auto num_threads = omp_get_max_threads();
+    std::vector<std::vector<std::pair<NodeIndex,NodeIndex>>> local_edges(num_threads);
 
-    auto addEdge = [&graph] (int u, int v, int tid) {
-        assert(tid == 0);
-        graph.emplace_back(u,v);
+    auto addEdge = [&local_edges] (NodeIndex u, NodeIndex v, int tid) {
+        local_edges[tid].emplace_back(u,v);
     };
 
     auto generator = hypergirgs::makeHyperbolicTree(radii, angles, T, R, addEdge);
+    generator.setStatistics(stats);
     generator.generate(seed);
 
+    if (num_threads == 1)
+        return std::move(local_edges[0]);
+
+    std::vector<std::size_t> offsets(num_threads + 1, 0);
+    for (int thread = 0; thread < num_threads; ++thread)
+        offsets[thread + 1] = offsets[thread] + local_edges[thread].size();
+
+    std::vector<std::pair<NodeIndex,NodeIndex>> graph(offsets.back());
+    #pragma omp parallel for schedule(static, 1), num_threads(num_threads)
+    for (int thread = 0; thread < num_threads; ++thread) {
+        std::copy(local_edges[thread].cbegin(), local_edges[thread].cend(), graph.begin() + offsets[thread]);
+        std::vector<std::pair<NodeIndex,NodeIndex>>().swap(local_edges[thread]);
+    }
+
     return graph;
 }
 
@@ -9,7 +9,7 @@
 namespace hypergirgs {
 
 
-RadiusLayer::RadiusLayer(double r_min, double r_max, unsigned int targetLevel, const std::vector<int> &nodes,
+RadiusLayer::RadiusLayer(double r_min, double r_max, unsigned int targetLevel, const std::vector<NodeIndex> &nodes,
                          const std::vector<double> &angles, const std::vector<Point> &points)
 : m_r_min(r_min)
 , m_r_max(r_max)
@@ -29,7 +29,7 @@ RadiusLayer::RadiusLayer(double r_min, double r_max, unsigned int targetLevel, c
     // compute exclusive prefix sums
     // prefix_sums[i] is the number of all points in cells j<i of the same level
     {
-        unsigned sum = 0;
+        NodeIndex sum = 0;
         for(auto& val : m_prefix_sums)  {
             const auto tmp = val;
             val = sum;
@@ -40,7 +40,7 @@ RadiusLayer::RadiusLayer(double r_min, double r_max, unsigned int targetLevel, c
     m_points.resize(m_prefix_sums.back());
 
     // fill point lookup
-    auto num_inserted = std::vector<int>(cellsInLevel, 0); // keeps track of bucket size for counting sort
+    auto num_inserted = std::vector<NodeIndex>(cellsInLevel, 0); // keeps track of bucket size for counting sort
     for(auto node : nodes){
         auto targetCell = AngleHelper::cellForPoint(angles[node], targetLevel);
         m_points[m_prefix_sums[targetCell] + num_inserted[targetCell]] = points[node];
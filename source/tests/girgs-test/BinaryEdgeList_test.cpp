@@ -0,0 +1,92 @@
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include <gmock/gmock.h>
+
+#include <girgs/BinaryEdgeList.h>
+#include <girgs/Generator.h>
+
+
+using namespace std;
+
+
+class BinaryEdgeList_test: public testing::Test
+{
+protected:
+    int seed = 1337;
+    string file = "BinaryEdgeList_test.bin";
+
+    void TearDown() override {
+        std::remove(file.c_str());
+    }
+};
+
+
+TEST_F(BinaryEdgeList_test, testGeneratorRoundTrip)
+{
+    auto n = 10000;
+    auto alphas = { 1.5, std::numeric_limits<double>::infinity() };
+
+    for (auto alpha : alphas) {
+        girgs::Generator g;
+        g.setWeights(n, -2.5, seed);
+        g.setPositions(n, 2, seed + 1);
+        g.scaleWeights(10, 2, alpha);
+        g.generate(alpha, seed + 2);
+        g.saveBinaryEdgeList(file);
+
+        girgs::BinaryEdgeList list(file);
+        ASSERT_EQ(list.numNodes(), n);
+        ASSERT_EQ(list.numEdges(), g.edges());
+        ASSERT_EQ(list.indexBytes(), 4);
+
+        // same order as in the text edge list
+        auto pairs = list.edges<std::uint32_t>();
+        auto k = 0ull;
+        for (auto& from : g.graph()) {
+            for (auto to : from.edges) {
+                EXPECT_EQ(pairs[2*k], from.index);
+                EXPECT_EQ(pairs[2*k+1], to->index);
+                EXPECT_EQ(list.edge(k), make_pair(std::uint64_t(from.index), std::uint64_t(to->index)));
+                ++k;
+            }
+        }
+    }
+}
+
+
+TEST_F(BinaryEdgeList_test, testWideIndices)
+{
+    const auto n = std::uint64_t(1) << 40;
+    const auto m = std::uint64_t(1000);
+    ASSERT_EQ(girgs::BinaryEdgeListWriter::indexBytesFor(n), 8);
+    {
+        girgs::BinaryEdgeListWriter writer(file, n, m, 8);
+        auto pairs = writer.edges<std::uint64_t>();
+        for (auto k = std::uint64_t(0); k < m; ++k) {
+            pairs[2*k] = k;
+            pairs[2*k+1] = n - 1 - k;
+        }
+    }
+
+    girgs::BinaryEdgeList list(file);
+    ASSERT_EQ(list.numNodes(), n);
+    ASSERT_EQ(list.numEdges(), m);
+    ASSERT_EQ(list.indexBytes(), 8);
+    for (auto k = std::uint64_t(0); k < m; ++k)
+        EXPECT_EQ(list.edge(k), make_pair(k, n - 1 - k));
+}
+
+
+TEST_F(BinaryEdgeList_test, testInvalidFile)
+{
+    {
+        auto f = ofstream(file);
+        f << "0 0\n";
+    }
+    EXPECT_THROW(girgs::BinaryEdgeList{file}, std::runtime_error);
+    EXPECT_THROW(girgs::BinaryEdgeList{"BinaryEdgeList_test_missing.bin"}, std::runtime_error);
+}
@@ -0,0 +1,93 @@
+
+#include <cstdint>
+#include <limits>
+#include <random>
+
+#include <gmock/gmock.h>
+
+#include <girgs/BitManipulation.h>
+
+
+using namespace std;
+using namespace girgs;
+
+
+class BitManipulation_test: public testing::Test
+{
+protected:
+    mt19937 gen{1337};
+};
+
+
+// compares an implementation against the naive reference for random coordinates and checks that extract inverts deposit
+template<unsigned int D, typename Impl>
+void testImplementation(mt19937& gen) {
+    using Code = typename Impl::code_type;
+    using Reference = BitManipulation::Naive<D, Code>;
+    const auto usedBits = Impl::bitsPerCoord * D;
+    uniform_int_distribution<Code> coordDist(0, static_cast<Code>(numeric_limits<Code>::max() >> (8 * sizeof(Code) - Impl::bitsPerCoord)));
+    uniform_int_distribution<Code> codeDist(0, static_cast<Code>(numeric_limits<Code>::max() >> (8 * sizeof(Code) - usedBits)));
+
+    for (auto i = 0; i < 10000; ++i) {
+        array<Code, D> coords;
+        for (auto& coord : coords)
+            coord = coordDist(gen);
+
+        const auto code = Impl::deposit(coords);
+        EXPECT_EQ(Reference::deposit(coords), code) << Impl::name() << " D=" << D;
+        EXPECT_EQ(coords, Impl::extract(code)) << Impl::name() << " D=" << D;
+
+        const auto randomCode = codeDist(gen);
+        EXPECT_EQ(Reference::extract(randomCode), Impl::extract(randomCode)) << Impl::name() << " D=" << D;
+        EXPECT_EQ(randomCode, Impl::deposit(Impl::extract(randomCode))) << Impl::name() << " D=" << D;
+    }
+}
+
+template<unsigned int D, typename Code = uint32_t>
+void testAllImplementations(mt19937& gen) {
+    testImplementation<D, BitManipulation::Naive<D, Code>>(gen);
+    testImplementation<D, BitManipulation::MagicBits<D, Code>>(gen);
+#ifdef __BMI2__
+    testImplementation<D, BitManipulation::BMI2<D, Code>>(gen);
+#endif
+}
+
+
+TEST_F(BitManipulation_test, testNaiveInterleaving)
+{
+    using Naive2 = BitManipulation::Naive<2>;
+    EXPECT_EQ(Naive2::deposit({{3, 0}}), 5u);
+    EXPECT_EQ(Naive2::deposit({{0, 3}}), 10u);
+    EXPECT_EQ(Naive2::deposit({{2, 1}}), 6u);
+
+    using Naive3 = BitManipulation::Naive<3>;
+    EXPECT_EQ(Naive3::deposit({{1, 0, 0}}), 1u);
+    EXPECT_EQ(Naive3::deposit({{0, 0, 1}}), 4u);
+    EXPECT_EQ(Naive3::deposit({{2, 0, 0}}), 8u);
+}
+
+TEST_F(BitManipulation_test, testImplementationsAgree)
+{
+    testAllImplementations<1>(gen);
+    testAllImplementations<2>(gen);
+    testAllImplementations<3>(gen);
+    testAllImplementations<4>(gen);
+    testAllImplementations<5>(gen);
+    testAllImplementations<7>(gen);
+}
+
+TEST_F(BitManipulation_test, testImplementationsAgree64)
+{
+    testAllImplementations<1, uint64_t>(gen);
+    testAllImplementations<2, uint64_t>(gen);
+    testAllImplementations<3, uint64_t>(gen);
+    testAllImplementations<4, uint64_t>(gen);
+    testAllImplementations<5, uint64_t>(gen);
+    testAllImplementations<7, uint64_t>(gen);
+
+    // the highest coordinate bits end up in the upper half of the code
+    using Naive2 = BitManipulation::Naive<2, uint64_t>;
+    using MagicBits2 = BitManipulation::MagicBits<2, uint64_t>;
+    EXPECT_EQ(Naive2::deposit({{uint64_t(1) << 31, 0}}), uint64_t(1) << 62);
+    EXPECT_EQ(MagicBits2::deposit({{0, uint64_t(1) << 31}}), uint64_t(1) << 63);
+}
@@ -0,0 +1,49 @@
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include <gmock/gmock.h>
+
+#include <girgs/FastMath.h>
+
+
+using namespace std;
+using namespace girgs;
+
+
+class FastMath_test: public testing::Test
+{
+protected:
+    mt19937_64 gen{1337};
+};
+
+
+TEST_F(FastMath_test, testLog2ErrorBound)
+{
+    // random mantissas over the whole range of normal doubles below 1, which contains all distances
+    auto exponentDist = uniform_int_distribution<int>(numeric_limits<double>::min_exponent, 0);
+    auto mantissaDist = uniform_real_distribution<double>(0.5, 1.0);
+    for (auto i = 0; i < 1000000; ++i) {
+        const auto x = ldexp(mantissaDist(gen), exponentDist(gen));
+        EXPECT_NEAR(FastMath::log2(x), static_cast<double>(log2l(x)), FastMath::c_log2Error) << x;
+    }
+
+    // the reduction of the mantissa switches at sqrt(2)
+    for (auto x : {1.0, 0.5, 0.7071067811865475, 0.7071067811865476, 1.4142135623730950, 1.4142135623730951, 1e-300})
+        EXPECT_NEAR(FastMath::log2(x), static_cast<double>(log2l(x)), FastMath::c_log2Error) << x;
+}
+
+
+TEST_F(FastMath_test, testExp2ErrorBound)
+{
+    auto yDist = uniform_real_distribution<double>(-1000.0, 1000.0);
+    for (auto i = 0; i < 1000000; ++i) {
+        const auto y = yDist(gen);
+        const auto exact = exp2l(y);
+        EXPECT_LE(fabsl((FastMath::exp2(y) - exact) / exact), FastMath::c_exp2Error) << y;
+    }
+
+    for (auto y : {-1000.0, -0.5, 0.0, 0.5, 1000.0})
+        EXPECT_LE(fabsl((FastMath::exp2(y) - exp2l(y)) / exp2l(y)), FastMath::c_exp2Error) << y;
+}
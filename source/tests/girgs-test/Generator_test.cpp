@@ -1,12 +1,21 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
 #include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#include <omp.h>
 
 #include <gmock/gmock.h>
 
 #include <girgs/Generator.h>
 #include <girgs/Node.h>
+#include <girgs/SpatialTree.h>
 
 
 using namespace std;
@@ -270,6 +279,59 @@ TEST_F(Generator_test, testWeightSampling)
 }
 
 
+TEST_F(Generator_test, testWeightSamplingIndependentOfThreads)
+{
+    auto n = 100000;
+    auto ple = -2.5;
+    const auto max_threads = omp_get_max_threads();
+
+    auto reference = vector<double>();
+    for (auto threads : { 1, 3, 4 }) {
+        omp_set_num_threads(threads);
+        girgs::Generator g;
+        g.setWeights(n, ple, seed);
+        if (reference.empty())
+            reference = g.weights();
+        else
+            EXPECT_EQ(reference, g.weights()) << "threads=" << threads;
+    }
+    omp_set_num_threads(max_threads);
+
+    // different seeds give different weights
+    girgs::Generator g;
+    g.setWeights(n, ple, seed + 1);
+    EXPECT_NE(reference, g.weights());
+}
+
+
+TEST_F(Generator_test, testPositionSamplingIndependentOfThreads)
+{
+    auto n = 100000;
+    auto d = 3;
+    const auto max_threads = omp_get_max_threads();
+
+    auto reference = vector<vector<double>>();
+    for (auto threads : { 1, 3, 4 }) {
+        omp_set_num_threads(threads);
+        girgs::Generator g;
+        g.setPositions(n, d, seed);
+        if (reference.empty())
+            reference = g.positions();
+        else
+            EXPECT_EQ(reference, g.positions()) << "threads=" << threads;
+    }
+    omp_set_num_threads(max_threads);
+
+    for (auto& position : reference) {
+        ASSERT_EQ(position.size(), d);
+        for (auto coord : position) {
+            EXPECT_GE(coord, 0.0);
+            EXPECT_LT(coord, 1.0);
+        }
+    }
+}
+
+
 TEST_F(Generator_test, testReproducible)
 {
     auto n = 1000;
@@ -315,4 +377,422 @@ TEST_F(Generator_test, testReproducible)
 
         
     }
+}
+
+TEST_F(Generator_test, testEdgeCallback)
+{
+    auto n = 1000;
+    auto ple = -2.5;
+    auto avg_deg = 10;
+
+    auto alphas = { 1.5, std::numeric_limits<double>::infinity() };
+    auto dimensions = { 1, 2, 3 };
+
+    for (auto alpha : alphas) {
+        for (auto d : dimensions) {
+            girgs::Generator g;
+            g.setWeights(n, ple, seed);
+            g.setPositions(n, d, seed + d);
+            g.scaleWeights(avg_deg, d, alpha);
+
+            // stored edges
+            g.generate(alpha, seed);
+            auto expected = vector<pair<int,int>>();
+            for (auto& node : g.graph())
+                for (auto neighbor : node.edges)
+                    expected.emplace_back(node.index, neighbor->index);
+
+            // streamed edges with the same seed
+            auto buffers = vector<vector<pair<int,int>>>(omp_get_max_threads());
+            auto addEdge = [&buffers](int u, int v, int tid) {
+                buffers[tid].emplace_back(u, v);
+            };
+            g.generate(alpha, seed, addEdge);
+            EXPECT_EQ(g.edges(), 0u); // the stored edges belong to the previous graph
+            auto streamed = vector<pair<int,int>>();
+            for (auto& buffer : buffers)
+                streamed.insert(streamed.end(), buffer.begin(), buffer.end());
+
+            sort(expected.begin(), expected.end());
+            sort(streamed.begin(), streamed.end());
+            EXPECT_EQ(expected, streamed);
+        }
+    }
+}
+
+
+TEST_F(Generator_test, testCompressedGraph)
+{
+    auto n = 1000;
+    auto ple = -2.5;
+    auto avg_deg = 10;
+
+    auto alphas = { 1.5, std::numeric_limits<double>::infinity() };
+    auto dimensions = { 1, 2 };
+
+    for (auto alpha : alphas) {
+        for (auto d : dimensions) {
+            girgs::Generator g;
+            g.setWeights(n, ple, seed);
+            g.setPositions(n, d, seed + d);
+            g.scaleWeights(avg_deg, d, alpha);
+
+            // stored edges
+            g.generate(alpha, seed);
+            auto adjacency = vector<vector<unsigned int>>(n);
+            auto symmetric_adjacency = vector<vector<unsigned long long>>(n);
+            for (auto& node : g.graph()) {
+                for (auto neighbor : node.edges) {
+                    adjacency[node.index].push_back(neighbor->index);
+                    symmetric_adjacency[node.index].push_back(neighbor->index);
+                    symmetric_adjacency[neighbor->index].push_back(node.index);
+                }
+            }
+
+            auto m = g.edges();
+            auto csr = g.generateCompressed<unsigned int>(alpha, seed);
+            auto symmetric_csr = g.generateCompressed<unsigned long long>(alpha, seed, true);
+            EXPECT_EQ(g.edges(), 0u); // the stored edges belong to the previous graph
+            ASSERT_EQ(csr.numNodes(), n);
+            ASSERT_EQ(symmetric_csr.numNodes(), n);
+            EXPECT_EQ(csr.numEdges(), m);
+            EXPECT_EQ(symmetric_csr.numEdges(), m);
+
+            for (int u = 0; u < n; ++u) {
+                sort(adjacency[u].begin(), adjacency[u].end());
+                sort(symmetric_adjacency[u].begin(), symmetric_adjacency[u].end());
+                EXPECT_EQ(adjacency[u], vector<unsigned int>(csr.neighborsBegin(u), csr.neighborsEnd(u)));
+                EXPECT_EQ(symmetric_adjacency[u], vector<unsigned long long>(symmetric_csr.neighborsBegin(u), symmetric_csr.neighborsEnd(u)));
+            }
+        }
+    }
+}
+
+
+TEST_F(Generator_test, testCompressedGraphIndexOverflow)
+{
+    auto n = 300;
+    girgs::Generator g;
+    g.setWeights(n, -2.5, seed);
+    g.setPositions(n, 1, seed + 1);
+    g.scaleWeights(10, 1, 1.5);
+
+    // node 299 does not fit into 8 bits, this must not depend on assertions
+    EXPECT_THROW(g.generateCompressed<unsigned char>(1.5, seed), std::overflow_error);
+    EXPECT_NO_THROW(g.generateCompressed<unsigned short>(1.5, seed));
+}
+
+
+TEST_F(Generator_test, testDeterministicMode)
+{
+    auto n = 10000;
+    auto ple = -2.5;
+    auto avg_deg = 10;
+
+    auto alphas = { 1.5, std::numeric_limits<double>::infinity() };
+    auto dimensions = { 1, 2, 3 };
+    auto thread_counts = { 1, 3, 4 };
+    const auto max_threads = omp_get_max_threads();
+
+    for (auto alpha : alphas) {
+        for (auto d : dimensions) {
+            girgs::Generator g;
+            g.setDeterministic(true);
+            g.setWeights(n, ple, seed);
+            g.setPositions(n, d, seed + d);
+            g.scaleWeights(avg_deg, d, alpha);
+
+            // adjacency lists including their order for each number of threads
+            auto reference = vector<vector<int>>();
+            for (auto threads : thread_counts) {
+                omp_set_num_threads(threads);
+                g.generate(alpha, seed);
+                auto adjacency = vector<vector<int>>(n);
+                for (auto& node : g.graph())
+                    for (auto neighbor : node.edges)
+                        adjacency[node.index].push_back(neighbor->index);
+
+                if (reference.empty())
+                    reference = std::move(adjacency);
+                else
+                    EXPECT_EQ(reference, adjacency) << "alpha=" << alpha << " d=" << d << " threads=" << threads;
+            }
+            omp_set_num_threads(max_threads);
+            EXPECT_GT(g.avg_degree(), 0.5 * avg_deg);
+        }
+    }
+}
+
+
+TEST_F(Generator_test, testClusteredPositionsReproducible)
+{
+    auto n = 3000;
+    auto d = 2;
+    auto alpha = 1.5;
+    const auto max_threads = omp_get_max_threads();
+
+    // all nodes in a corner, so most buckets of the parallel phase are empty
+    auto positions = vector<vector<double>>(n, vector<double>(d));
+    auto gen = default_random_engine(seed);
+    auto dist = uniform_real_distribution<double>(0.0, 0.2);
+    for (auto& position : positions)
+        for (auto& coord : position)
+            coord = dist(gen);
+
+    auto adjacencyOf = [n](const girgs::Generator& g) {
+        auto adjacency = vector<vector<int>>(n);
+        for (auto& node : g.graph())
+            for (auto neighbor : node.edges)
+                adjacency[node.index].push_back(neighbor->index);
+        return adjacency;
+    };
+
+    for (auto deterministic : { false, true }) {
+        girgs::Generator g;
+        g.setDeterministic(deterministic);
+        g.setWeights(n, -2.5, seed);
+        g.setPositions(positions);
+        g.scaleWeights(10, d, alpha);
+
+        // the assignment of buckets to threads must only depend on the input and the number of threads
+        omp_set_num_threads(4);
+        g.generate(alpha, seed);
+        auto reference = adjacencyOf(g);
+        g.generate(alpha, seed);
+        EXPECT_EQ(reference, adjacencyOf(g)) << "deterministic=" << deterministic;
+
+        if (deterministic) {
+            omp_set_num_threads(1);
+            g.generate(alpha, seed);
+            EXPECT_EQ(reference, adjacencyOf(g));
+        }
+        omp_set_num_threads(max_threads);
+        EXPECT_GT(g.avg_degree(), 5);
+    }
+}
+
+
+TEST_F(Generator_test, testThresholdTasksIndependentOfThreads)
+{
+    auto n = 20000;
+    auto alpha = std::numeric_limits<double>::infinity();
+    auto dimensions = { 1, 2 };
+    auto thread_counts = { 2, 3, 4 };
+    const auto max_threads = omp_get_max_threads();
+
+    for (auto d : dimensions) {
+        girgs::Generator g;
+        g.setWeights(n, -2.1, seed);
+        g.setPositions(n, d, seed + d);
+        g.scaleWeights(10, d, alpha);
+
+        auto adjacencyOf = [n, &g]() {
+            auto adjacency = vector<vector<int>>(n);
+            for (auto& node : g.graph())
+                for (auto neighbor : node.edges)
+                    adjacency[node.index].push_back(neighbor->index);
+            return adjacency;
+        };
+
+        // the task of a cell is the only one adding edges to its nodes, so even the order does not depend on the threads
+        auto reference = vector<vector<int>>();
+        for (auto threads : thread_counts) {
+            omp_set_num_threads(threads);
+            g.generate(alpha, seed);
+            if (reference.empty())
+                reference = adjacencyOf();
+            else
+                EXPECT_EQ(reference, adjacencyOf()) << "d=" << d << " threads=" << threads;
+        }
+
+        // the sequential recursion visits the cell pairs in another order
+        omp_set_num_threads(1);
+        g.generate(alpha, seed);
+        auto sequential = adjacencyOf();
+        for (auto u = 0; u < n; ++u) {
+            sort(reference[u].begin(), reference[u].end());
+            sort(sequential[u].begin(), sequential[u].end());
+        }
+        EXPECT_EQ(reference, sequential) << "d=" << d;
+        omp_set_num_threads(max_threads);
+    }
+}
+
+
+TEST_F(Generator_test, testShards)
+{
+    auto n = 10000;
+    auto ple = -2.5;
+    auto avg_deg = 10;
+
+    auto alphas = { 1.5, std::numeric_limits<double>::infinity() };
+    auto dimensions = { 1, 2, 3 };
+    auto shard_counts = { 2, 7 };
+
+    for (auto alpha : alphas) {
+        for (auto d : dimensions) {
+            girgs::Generator g;
+            g.setWeights(n, ple, seed);
+            g.setPositions(n, d, seed + d);
+            g.scaleWeights(avg_deg, d, alpha);
+
+            auto edgesOf = [&g]() {
+                auto edges = vector<pair<int,int>>();
+                for (auto& node : g.graph())
+                    for (auto neighbor : node.edges)
+                        edges.emplace_back(node.index, neighbor->index);
+                return edges;
+            };
+
+            g.setDeterministic(true);
+            g.generate(alpha, seed);
+            auto expected = edgesOf();
+            sort(expected.begin(), expected.end());
+
+            // the shards are disjoint and together form the graph
+            g.setDeterministic(false);
+            for (auto k : shard_counts) {
+                auto united = vector<pair<int,int>>();
+                for (auto shard = 0; shard < k; ++shard) {
+                    g.setShard(shard, k);
+                    g.generate(alpha, seed);
+                    auto edges = edgesOf();
+                    EXPECT_GT(edges.size(), 0u);
+                    united.insert(united.end(), edges.begin(), edges.end());
+                }
+                sort(united.begin(), united.end());
+                EXPECT_EQ(expected, united) << "alpha=" << alpha << " d=" << d << " shards=" << k;
+            }
+            g.setShard(0, 1);
+        }
+    }
+}
+
+
+TEST_F(Generator_test, testStatistics)
+{
+    auto n = 10000;
+    auto ple = -2.5;
+    auto avg_deg = 10;
+
+    auto alphas = { 1.5, std::numeric_limits<double>::infinity() };
+    auto dimensions = { 1, 2 };
+
+    for (auto alpha : alphas) {
+        for (auto d : dimensions) {
+            girgs::Generator g;
+            g.setWeights(n, ple, seed);
+            g.setPositions(n, d, seed + d);
+            g.scaleWeights(avg_deg, d, alpha);
+
+            g.generate(alpha, seed);
+            auto expected = g.edges();
+
+            // statistics do not change the graph and are reset for each generation
+            girgs::GenerationStats stats;
+            g.setStatistics(&stats);
+            for (auto round = 0; round < 2; ++round) {
+                g.generate(alpha, seed);
+                EXPECT_EQ(g.edges(), expected);
+
+                ASSERT_EQ(stats.threads.size(), omp_get_max_threads());
+                ASSERT_GT(stats.levels, 0u);
+                EXPECT_EQ(stats.cellPairVisits(0), 1u);
+                EXPECT_GT(stats.typeIPairs(), expected);
+                EXPECT_LE(stats.typeIIAccepted(), stats.typeIICandidates());
+                EXPECT_LE(stats.typeIIAccepted(), expected);
+                if (alpha == std::numeric_limits<double>::infinity())
+                    EXPECT_EQ(stats.typeIICandidates(), 0u);
+                else
+                    EXPECT_GT(stats.typeIIAccepted(), 0u);
+            }
+            g.setStatistics(nullptr);
+        }
+    }
+}
+
+
+TEST_F(Generator_test, testSaveEdgeList)
+{
+    auto n = 50000;
+    auto d = 2;
+    auto alpha = 1.5;
+    auto file = string("Generator_test_edges.txt");
+
+    girgs::Generator g;
+    g.setWeights(n, -2.5, seed);
+    g.setPositions(n, d, seed + d);
+    g.scaleWeights(10, d, alpha);
+    g.generate(alpha, seed);
+    g.saveEdgeList(file);
+
+    // layout produced by plain iostreams
+    ostringstream expected;
+    expected << g.graph().size() << ' ' << g.edges() << '\n';
+    for (auto& from : g.graph())
+        for (auto to : from.edges)
+            expected << from.index << ' ' << to->index << '\n';
+
+    ostringstream actual;
+    actual << ifstream(file).rdbuf();
+    std::remove(file.c_str());
+
+    EXPECT_EQ(expected.str(), actual.str());
+}
+
+
+TEST_F(Generator_test, testWeightScalingIndependentOfThreads)
+{
+    auto n = 100000;
+    auto ple = -2.2;
+    auto d = 2;
+    const auto max_threads = omp_get_max_threads();
+
+    for (auto alpha : { 1.5, std::numeric_limits<double>::infinity() }) {
+        auto reference = 0.0;
+        for (auto threads : { 1, 3, 4 }) {
+            omp_set_num_threads(threads);
+            girgs::Generator g;
+            g.setWeights(n, ple, seed);
+            auto scaling = g.scaleWeights(50, d, alpha);
+            if (reference == 0.0)
+                reference = scaling;
+            else
+                EXPECT_EQ(reference, scaling) << "threads=" << threads << " alpha=" << alpha;
+        }
+    }
+    omp_set_num_threads(max_threads);
+}
+
+
+TEST_F(Generator_test, testThresholdSpecialization)
+{
+    const auto n = 20000;
+    const auto d = 2u;
+    const auto alpha = numeric_limits<double>::infinity();
+
+    girgs::Generator generator;
+    generator.setWeights(n, -2.5, seed);
+    generator.setPositions(n, d, seed);
+    generator.scaleWeights(10, d, alpha);
+    auto graph = generator.graph();
+
+    // the specialized tree compares radii instead of weights and distances but must find the same edges
+    auto sampleEdges = [&graph, alpha](bool specialized) {
+        auto edges = vector<vector<pair<int, int>>>(omp_get_max_threads());
+        auto addEdge = [&edges](int u, int v, int tid) { edges[tid].emplace_back(min(u, v), max(u, v)); };
+        if (specialized)
+            girgs::SpatialTree<d, true>().generateEdges(graph, alpha, 0, addEdge);
+        else
+            girgs::SpatialTree<d, false>().generateEdges(graph, alpha, 0, addEdge);
+        auto result = vector<pair<int, int>>();
+        for (auto& each : edges)
+            result.insert(result.end(), each.begin(), each.end());
+        sort(result.begin(), result.end());
+        return result;
+    };
+
+    const auto generic = sampleEdges(false);
+    EXPECT_GT(generic.size(), 0u);
+    EXPECT_EQ(generic, sampleEdges(true));
 }
\ No newline at end of file
@@ -84,6 +84,24 @@ void testCoordMapping(SpatialTreeCoordinateHelper<D>& helper) {
     }
 }
 
+template<unsigned int D>
+void testCellCoords(SpatialTreeCoordinateHelper<D>& helper) {
+    using Helper = SpatialTreeCoordinateHelper<D>;
+
+    // construct coordinates of all cells top down: a child doubles the coordinates of its parent
+    // and adds the d-th bit of its position among its siblings in dimension d
+    auto coords = vector<array<typename Helper::CellCoord, D>>(Helper::firstCellOfLevel(helper.levels()));
+    coords[0].fill(0);
+    for(auto l=1u; l<helper.levels(); ++l) {
+        for(auto cell = Helper::firstCellOfLevel(l); cell < Helper::firstCellOfLevel(l+1); ++cell) {
+            auto sibling = (cell-1) % Helper::numChildren();
+            for(auto d=0u; d<D; ++d)
+                coords[cell][d] = 2*coords[Helper::parent(cell)][d] + ((sibling >> d) & 1);
+            EXPECT_EQ(coords[cell], Helper::cellCoords(cell, l));
+        }
+    }
+}
+
 
 TEST_F(SpatialTreeCoordinateHelper_test, testTreeStructure)
 {
@@ -103,6 +121,15 @@ TEST_F(SpatialTreeCoordinateHelper_test, testCoordMapping)
 }
 
 
+TEST_F(SpatialTreeCoordinateHelper_test, testCellCoords)
+{
+    testCellCoords(b1);
+    testCellCoords(b2);
+    testCellCoords(b3);
+    testCellCoords(b4);
+}
+
+
 TEST_F(SpatialTreeCoordinateHelper_test, testTouching)
 {
     // TODO write better test for touching
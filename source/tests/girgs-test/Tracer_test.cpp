@@ -0,0 +1,97 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <omp.h>
+
+#include <gmock/gmock.h>
+
+#include <girgs/Generator.h>
+#include <girgs/Tracer.h>
+
+
+using namespace std;
+
+
+class Tracer_test: public testing::Test
+{
+protected:
+    string file = "Tracer_test.json";
+
+    void SetUp() override {
+        girgs::Tracer::global().clear();
+        girgs::Tracer::global().setMaxLevel(-1);
+    }
+
+    void TearDown() override {
+        girgs::Tracer::global().clear();
+        std::remove(file.c_str());
+    }
+};
+
+
+TEST_F(Tracer_test, testSpansAreWritten)
+{
+    auto& tracer = girgs::Tracer::global();
+    tracer.prepare(omp_get_max_threads());
+    {
+        girgs::TraceSpan span("outer", 1, 3, 42);
+        auto thread = omp_get_thread_num();
+        for (int i = 0; i < 5; ++i)
+            tracer.countEdge(thread);
+        girgs::TraceSpan inactive("inactive", 2, 7, 0, false);
+    }
+
+    ASSERT_EQ(tracer.events(0).size(), 1);
+    auto& event = tracer.events(0).front();
+    EXPECT_STREQ(event.name, "outer");
+    EXPECT_EQ(event.level, 1);
+    EXPECT_EQ(event.cell, 3);
+    EXPECT_EQ(event.points, 42);
+    EXPECT_EQ(event.edges, 5);
+    EXPECT_GE(event.duration, 0.0);
+
+    tracer.write(file);
+    ifstream in(file);
+    auto json = string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    EXPECT_NE(json.find("\"traceEvents\""), string::npos);
+    EXPECT_NE(json.find("\"name\":\"outer\""), string::npos);
+    EXPECT_NE(json.find("\"ph\":\"X\""), string::npos);
+    EXPECT_EQ(json.find("inactive"), string::npos);
+}
+
+
+TEST_F(Tracer_test, testGenerationIsTraced)
+{
+    auto n = 10000;
+    girgs::Generator g;
+    g.setWeights(n, -2.5, 12);
+    g.setPositions(n, 2, 13);
+    g.scaleWeights(10, 2, 2.0);
+    g.generate(2.0, 14);
+
+    auto& tracer = girgs::Tracer::global();
+    if (!girgs::Tracer::enabled()) {
+        for (int t = 0; t < tracer.threads(); ++t)
+            EXPECT_TRUE(tracer.events(t).empty());
+        return;
+    }
+
+    // the top level span and the buckets of the parallel phase cover the whole graph and all its edges
+    auto edges = uint64_t(0);
+    auto topLevelSpans = 0;
+    for (int t = 0; t < tracer.threads(); ++t) {
+        for (auto& event : tracer.events(t)) {
+            if (event.level == 0) {
+                ++topLevelSpans;
+                EXPECT_EQ(event.points, n);
+            }
+            if (event.level == 0 || string(event.name) == "bucket")
+                edges += event.edges;
+        }
+    }
+    EXPECT_EQ(topLevelSpans, 1);
+    EXPECT_EQ(edges, g.edges());
+}
@@ -4,6 +4,7 @@
 #include <numeric>
 
 #include <gmock/gmock.h>
+#include <omp.h>
 
 #include <hypergirgs/HyperbolicTree.h>
 #include <hypergirgs/Hyperbolic.h>
@@ -25,23 +26,28 @@ TEST_F(HyperbolicTree_test, testNoDuplicateEdges)
 {
     const auto n = 1000;
     const auto alpha = 0.75; // ple = 2*alpha+1
-    const auto T = 0;
+    const auto Ts = {0.0, 0.5};
     const auto deg = 10;
 
-    auto R = hypergirgs::calculateRadius(n, alpha, T, deg);
-    auto radii = hypergirgs::sampleRadii(n, alpha, R, radiiSeed);
-    auto angles = hypergirgs::sampleAngles(n, angleSeed);
-    auto graph = hypergirgs::generateEdges(radii, angles, T, R, edgesSeed);
+    for(auto T : Ts) {
+        auto R = hypergirgs::calculateRadius(n, alpha, T, deg);
+        auto radii = hypergirgs::sampleRadii(n, alpha, R, radiiSeed);
+        auto angles = hypergirgs::sampleAngles(n, angleSeed);
+        auto graph = hypergirgs::generateEdges(radii, angles, T, R, edgesSeed);
+
+        auto duplicates = 0;
+        for(auto& edge : graph)
+            if(edge.first > edge.second)
+                swap(edge.first, edge.second);
+        sort(graph.begin(), graph.end());
+        for(int i=0; i<graph.size()-1; ++i){
+            auto current = graph[i];
+            auto next = graph[i+1];
+            duplicates += (current == next);
+        }
 
-    auto duplicates = 0;
-    sort(graph.begin(), graph.end());
-    for(int i=0; i<graph.size()-1; ++i){
-        auto current = graph[i];
-        auto next = graph[i+1];
-        duplicates += (current == next);
+        ASSERT_EQ(duplicates, 0);
     }
-
-    ASSERT_EQ(duplicates, 0);
 }
 
 
@@ -92,14 +98,50 @@ TEST_F(HyperbolicTree_test, testGeneralModel)
     auto angles = hypergirgs::sampleAngles(n, angleSeed);
     auto graph = hypergirgs::generateEdges(radii, angles, T, R, edgesSeed);
 
+    // expected number of edges given the sampled radii and angles
+    auto num_desired = 0.0;
+    for(int i=0; i<n; ++i)
+        for(int j=i+1; j<n; ++j)
+            num_desired += 1.0 / (1.0 + exp((hyperbolicDistance(radii[i], angles[i], radii[j], angles[j]) - R) / (2*T)));
+
     auto num_edges = graph.size();
-    auto num_desired = 0.5*deg*n;
-    auto rigor = 0.9;
+    auto rigor = 0.95;
     ASSERT_LE(rigor * num_edges, num_desired);
     ASSERT_LE(rigor * num_desired, num_edges);
 }
 
 
+TEST_F(HyperbolicTree_test, testStatistics)
+{
+    const auto n = 10000;
+    const auto alpha = 0.75; // ple = 2*alpha+1
+    const auto Ts = {0.0, 0.5};
+    const auto deg = 10;
+
+    for(auto T : Ts) {
+        auto R = hypergirgs::calculateRadius(n, alpha, T, deg);
+        auto radii = hypergirgs::sampleRadii(n, alpha, R, radiiSeed);
+        auto angles = hypergirgs::sampleAngles(n, angleSeed);
+        auto stats = hypergirgs::GenerationStats();
+        auto graph = hypergirgs::generateEdges(radii, angles, T, R, edgesSeed, &stats);
+
+        // statistics do not change the graph
+        EXPECT_EQ(graph, hypergirgs::generateEdges(radii, angles, T, R, edgesSeed));
+
+        ASSERT_EQ(stats.threads.size(), omp_get_max_threads());
+        ASSERT_GT(stats.levels, 0u);
+        EXPECT_EQ(stats.cellPairVisits(0), 1u);
+        EXPECT_GT(stats.typeIPairs(), graph.size());
+        EXPECT_LE(stats.typeIIAccepted(), stats.typeIICandidates());
+        EXPECT_LE(stats.typeIIAccepted(), graph.size());
+        if (T == 0.0)
+            EXPECT_EQ(stats.typeIICandidates(), 0u);
+        else
+            EXPECT_GT(stats.typeIIAccepted(), 0u);
+    }
+}
+
+
 TEST_F(HyperbolicTree_test, testReproducible)
 {
     const auto n = 1000;
@@ -118,3 +160,70 @@ TEST_F(HyperbolicTree_test, testReproducible)
         ASSERT_EQ(edges1, edges2);
     }
 }
+
+TEST_F(HyperbolicTree_test, testThresholdIndependentOfThreads)
+{
+    const auto n = 10000;
+    const auto alpha = 0.75; // ple = 2*alpha+1
+    const auto T = 0;
+    const auto deg = 10;
+
+    auto R = hypergirgs::calculateRadius(n, alpha, T, deg);
+    auto radii = hypergirgs::sampleRadii(n, alpha, R, radiiSeed);
+    auto angles = hypergirgs::sampleAngles(n, angleSeed);
+
+    const auto max_threads = omp_get_max_threads();
+    auto normalized_edges = [&] (int threads) {
+        omp_set_num_threads(threads);
+        auto edges = hypergirgs::generateEdges(radii, angles, T, R, edgesSeed);
+        for(auto& edge : edges)
+            if(edge.first > edge.second)
+                swap(edge.first, edge.second);
+        sort(edges.begin(), edges.end());
+        return edges;
+    };
+
+    auto sequential = normalized_edges(1);
+    auto parallel = normalized_edges(4);
+    omp_set_num_threads(max_threads);
+
+    ASSERT_EQ(sequential, parallel);
+}
+
+TEST_F(HyperbolicTree_test, testRadiiIndependentOfThreads)
+{
+    const auto n = 100000;
+    const auto alpha = 0.75; // ple = 2*alpha+1
+    const auto R = hypergirgs::calculateRadius(n, alpha, 0, 10);
+    const auto max_threads = omp_get_max_threads();
+
+    omp_set_num_threads(1);
+    auto sequential = hypergirgs::sampleRadii(n, alpha, R, radiiSeed);
+    omp_set_num_threads(4);
+    auto parallel = hypergirgs::sampleRadii(n, alpha, R, radiiSeed);
+    omp_set_num_threads(max_threads);
+
+    ASSERT_EQ(sequential, parallel);
+    for(auto r : sequential) {
+        EXPECT_GT(r, 0.0);
+        EXPECT_LE(r, R);
+    }
+}
+
+TEST_F(HyperbolicTree_test, testAnglesIndependentOfThreads)
+{
+    const auto n = 100000;
+    const auto max_threads = omp_get_max_threads();
+
+    omp_set_num_threads(1);
+    auto sequential = hypergirgs::sampleAngles(n, angleSeed);
+    omp_set_num_threads(4);
+    auto parallel = hypergirgs::sampleAngles(n, angleSeed);
+    omp_set_num_threads(max_threads);
+
+    ASSERT_EQ(sequential, parallel);
+    for(auto phi : sequential) {
+        EXPECT_GE(phi, 0.0);
+        EXPECT_LT(phi, 2*PI);
+    }
+}